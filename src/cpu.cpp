@@ -0,0 +1,65 @@
+#include "cpu.hpp"
+#include "types.hpp"
+#include "nn/kernels.hpp"
+
+#if defined(USE_DISPATCH)
+bool hasPext = false;
+#endif
+
+namespace Stella {
+
+namespace Kernels {
+
+const KernelSet* active = nullptr;
+
+// Kernels built by the makefile, see nn/kernels.cpp
+#if defined(USE_DISPATCH)
+namespace sse41 { extern const KernelSet kernels; }
+namespace avx2 { extern const KernelSet kernels; }
+namespace avx512 { extern const KernelSet kernels; }
+#else
+namespace native { extern const KernelSet kernels; }
+#endif
+
+}
+
+namespace Cpu {
+
+void init() {
+    #if defined(USE_DISPATCH)
+    __builtin_cpu_init();
+
+    // Take the widest registers the cpu and os support
+    if (__builtin_cpu_supports("avx512f")
+        && __builtin_cpu_supports("avx512bw")
+        && __builtin_cpu_supports("avx512dq"))
+        Kernels::active = &Kernels::avx512::kernels;
+    else if (__builtin_cpu_supports("avx2"))
+        Kernels::active = &Kernels::avx2::kernels;
+    else
+        Kernels::active = &Kernels::sse41::kernels;
+
+    // Pext is microcoded and slower than magics on the first two Zen generations
+    hasPext = __builtin_cpu_supports("bmi2")
+           && !__builtin_cpu_is("znver1")
+           && !__builtin_cpu_is("znver2");
+    #else
+    // Without dispatch the kernels and lookups are fixed when compiling
+    Kernels::active = &Kernels::native::kernels;
+    #endif
+}
+
+std::string description() {
+    std::string info = std::string(Kernels::active->name) + " network kernels, "
+                     + (hasPext ? "pext" : "magic") + " slider attacks";
+
+    #if defined(USE_DISPATCH)
+    info += ", chosen at runtime";
+    #endif
+
+    return info;
+}
+
+}
+
+}
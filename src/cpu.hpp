@@ -0,0 +1,17 @@
+#ifndef CPU_H_INCLUDED
+#define CPU_H_INCLUDED
+
+#include <string>
+
+namespace Stella::Cpu {
+
+// Detect the instruction sets of the cpu and choose the network kernels and
+// slider attack lookups to use. Must run before the bitboards are initialized.
+void init();
+
+// Describe the chosen code paths for an info string
+std::string description();
+
+}
+
+#endif
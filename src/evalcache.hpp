@@ -0,0 +1,61 @@
+#ifndef EVALCACHE_H_INCLUDED
+#define EVALCACHE_H_INCLUDED
+
+#include <cstdint>
+
+#include "types.hpp"
+
+namespace Stella {
+
+// Number of entries in each thread's eval cache, 16 bytes each
+constexpr int EVAL_CACHE_SIZE = 1 << 15;
+
+// Entry holding the scaled network output for a position
+struct EvalCacheEntry {
+    Key key;
+    Value score;
+};
+
+// Small direct mapped cache of evaluations. Each search thread owns one, so
+// entries need no protection and a colliding key simply replaces the slot.
+class EvalCache {
+private:
+    EvalCacheEntry entries[EVAL_CACHE_SIZE];
+
+    EvalCacheEntry& entry(Key key) { return entries[key & (EVAL_CACHE_SIZE - 1)]; }
+    const EvalCacheEntry& entry(Key key) const { return entries[key & (EVAL_CACHE_SIZE - 1)]; }
+
+public:
+    // Probe and hit counters, reset at the start of each search
+    uint64_t probes;
+    uint64_t hits;
+
+    EvalCache() { clear(); }
+
+    // Clear all entries and counters
+    void clear() {
+        for (EvalCacheEntry& e : entries) e = { 0, VALUE_NONE };
+        reset_stats();
+    }
+
+    void reset_stats() { probes = hits = 0; }
+
+    // Look for the score of a key, returns false if it is not stored
+    bool probe(Key key, Value& score) {
+        ++probes;
+        const EvalCacheEntry& e = entry(key);
+        if (e.key != key) return false;
+        ++hits;
+        score = e.score;
+        return true;
+    }
+
+    void save(Key key, Value score) { entry(key) = { key, score }; }
+
+    // Fetch the slot of a key ahead of the evaluation
+    void prefetch(Key key) const { __builtin_prefetch(&entry(key)); }
+};
+
+}
+
+#endif
@@ -9,8 +9,13 @@ void History::clear() {
     killers.fill(Move::none());
     butterflyHistory.fill(VALUE_ZERO);
     continuationHistory.fill(VALUE_ZERO);
+    emptyContinuation.fill(VALUE_ZERO);
+    for (auto& table : continuationStack)
+        table = &emptyContinuation;
     captureHistory.fill(VALUE_ZERO);
     evalHistory.fill(VALUE_ZERO);
+    pawnCorrection.fill(VALUE_ZERO);
+    nonPawnCorrection.fill(VALUE_ZERO);
 }
 
 void History::clear_killers_grandchildren(Color side, int ply) {
@@ -19,6 +24,16 @@ void History::clear_killers_grandchildren(Color side, int ply) {
     killers[side][ply + 2][1] = Move::none();
 }
 
+void History::set_continuation_move(int ply, Piece pc, Square to) {
+    assert(ply >= 0 && ply < MAX_PLY);
+    continuationStack[ply + 7] = &continuationHistory[pc][to];
+}
+
+void History::clear_continuation_move(int ply) {
+    assert(ply >= 0 && ply < MAX_PLY);
+    continuationStack[ply + 7] = &emptyContinuation;
+}
+
 Value History::get_history(Position* pos, Move m, int ply) const {
     assert(m.is_ok());
 
@@ -50,17 +65,15 @@ Value History::get_history(Position* pos, Move m, int ply) const {
 
         Value v;
 
-        // If in check we use a lower continuation history to account for unknowns
+        // If in check we only use the previous move to account for unknowns
         if (pos->checks())
             v = get_butterfly(us, m)
-              + get_continuation(pc, to, ply);
+              + get_continuation(pc, to, ply - 1);
         else
             v = get_butterfly(us, m) * 2
-              + get_continuation(pc, to, ply)
               + get_continuation(pc, to, ply - 1)
               + get_continuation(pc, to, ply - 2)
-              + get_continuation(pc, to, ply - 3)
-              + get_continuation(pc, to, ply - 5);
+              + get_continuation(pc, to, ply - 4);
 
         v += bool(pos->check_squares(pt) & to) * 16000;
 
@@ -92,7 +105,7 @@ Value History::get_capture(Piece pc, Square to, PieceType pt) const {
 
 Value History::get_continuation(Piece pc, Square sq, int ply) const {
     assert(ply >= -7 && ply < MAX_PLY);
-    return continuationHistory[pc][sq][ply + 7];
+    return (*continuationStack[ply + 7])[pc][sq];
 }
 
 Value History::get_eval(Color side, int ply) const {
@@ -117,16 +130,23 @@ void History::set_capture(Piece pc, Square to, PieceType pt, Value v) {
     captureHistory[pc][to][pt] = v;
 }
 
-void History::set_continuation(Piece pc, Square sq, int ply, Value v) {
-    assert(ply >= -7 && ply < MAX_PLY);
-    continuationHistory[pc][sq][ply + 7] = v;
-}
-
 void History::set_eval(Color side, int ply, Value v) {
     assert(ply >= 0 && ply < MAX_PLY);
     evalHistory[side][ply] = v;
 }
 
+Value History::correct_eval(Position* pos, Value v) const {
+    Color us = pos->side();
+
+    Value correction = pawnCorrection[us][pos->pawn_key() % CORRECTION_SIZE]
+                     + (nonPawnCorrection[WHITE][us][pos->non_pawn_key(WHITE) % CORRECTION_SIZE]
+                     +  nonPawnCorrection[BLACK][us][pos->non_pawn_key(BLACK) % CORRECTION_SIZE]) / 2;
+
+    // Entries are stored with a grain of 1/16 of a centipawn, keep the result
+    // away from mate scores
+    return std::clamp(v + correction / 16, VALUE_LOSS_MAX_PLY + 1, VALUE_WIN_MAX_PLY - 1);
+}
+
 bool History::is_improving(Color side, int ply, Value v) const {
     assert(ply >= 0 && ply < MAX_PLY);
     if (ply >= 2) return v > evalHistory[side][ply - 2];
@@ -154,9 +174,29 @@ void History::update_capture(Piece pc, Square to, PieceType pt, Value b) {
 
 void History::update_continuation(Piece pc, Square sq, int ply, Value b) {
     assert(ply >= -7 && ply < MAX_PLY);
-    auto& entry = continuationHistory[pc][sq][ply + 7];
+
+    // Plies without a move have no table to update
+    if (continuationStack[ply + 7] == &emptyContinuation) return;
+
+    auto& entry = (*continuationStack[ply + 7])[pc][sq];
     entry += b - entry * abs(b) / 25000;
     assert(abs(entry) <= 25000);
 }
 
+void History::update_correction(Position* pos, Value diff, Depth depth) {
+    Color us = pos->side();
+
+    // Scale the difference between the search score and static eval by depth
+    Value b = std::clamp(diff * depth * 2, -CORRECTION_LIMIT / 4, CORRECTION_LIMIT / 4);
+
+    auto update = [b](Value& entry) {
+        entry += b - entry * abs(b) / CORRECTION_LIMIT;
+        assert(abs(entry) <= CORRECTION_LIMIT);
+    };
+
+    update(pawnCorrection[us][pos->pawn_key() % CORRECTION_SIZE]);
+    update(nonPawnCorrection[WHITE][us][pos->non_pawn_key(WHITE) % CORRECTION_SIZE]);
+    update(nonPawnCorrection[BLACK][us][pos->non_pawn_key(BLACK) % CORRECTION_SIZE]);
+}
+
 }
\ No newline at end of file
@@ -45,24 +45,44 @@ public:
     }
 };
 
+// Number of entries in each correction history table and the entry limit
+constexpr int CORRECTION_SIZE = 16384;
+constexpr int CORRECTION_LIMIT = 1024;
+
+// Table of values indexed by piece and destination square
+using PieceToHistory = Stats<Value, PIECE_NB, SQ_NB>;
+
 struct History {
 private:
     // Killer moves, indexed with ply and side to move
     Stats<Move, COLOR_NB, MAX_PLY + 2, 2> killers;
     // Butterfly history, indexed by from and to
     Stats<Value, COLOR_NB, SQ_NB, SQ_NB> butterflyHistory;
-    // Continuation history, from Stockfish
-    Stats<Value, PIECE_NB, SQ_NB, MAX_PLY + 7> continuationHistory;
+    // Continuation history, indexed with the piece and to square of an earlier
+    // move, then the piece and to square of the current move
+    Stats<Value, PIECE_NB, SQ_NB, PIECE_NB, SQ_NB> continuationHistory;
+    // Continuation table of the move made at each ply, offset by 7 so that plies
+    // before the root are in bounds. Plies without a move point to an empty table.
+    PieceToHistory* continuationStack[MAX_PLY + 8];
+    PieceToHistory emptyContinuation;
     // Capture history, indexed with piece, cap sq and cap piece type
     Stats<Value, PIECE_NB, SQ_NB, PIECE_TYPE_NB> captureHistory;
     // Historic evaluation
     Stats<Value, COLOR_NB, MAX_PLY> evalHistory;
+    // Correction history of the static eval, indexed with side to move and the
+    // pawn key, or the side of the pieces, side to move and their non pawn key
+    Stats<Value, COLOR_NB, CORRECTION_SIZE> pawnCorrection;
+    Stats<Value, COLOR_NB, COLOR_NB, CORRECTION_SIZE> nonPawnCorrection;
 public:
     History() { clear(); };
     // Clear the structure
     void clear();
     // Reset grandchildren of current killer moves
     void clear_killers_grandchildren(Color side, int ply);
+    // Set the continuation table for the move made at a ply
+    void set_continuation_move(int ply, Piece pc, Square to);
+    // Set an empty continuation table for a null move made at a ply
+    void clear_continuation_move(int ply);
     // Function to return the history
     Value get_history(Position* pos, Move m, int ply) const;
     // Functions to get specific histories
@@ -75,8 +95,9 @@ public:
     void set_killer(Color side, Move m, int ply);
     void set_butterfly(Color side, Move m, Value v);
     void set_capture(Piece pc, Square to, PieceType pt, Value v);
-    void set_continuation(Piece pc, Square sq, int ply, Value v);
     void set_eval(Color side, int ply, Value v);
+    // Adjust a static eval with the correction histories of the position
+    Value correct_eval(Position* pos, Value v) const;
     // Find if position is improving based on historic eval
     bool is_improving(Color side, int ply, Value v) const;
     // Check if move is a killer
@@ -85,6 +106,7 @@ public:
     void update_butterfly(Color side, Move m, Value b);
     void update_capture(Piece pc, Square to, PieceType pt, Value b);
     void update_continuation(Piece pc, Square sq, int ply, Value b);
+    void update_correction(Position* pos, Value diff, Depth depth);
 };
 
 }
@@ -1,5 +1,6 @@
 #include <iostream>
 
+#include "cpu.hpp"
 #include "misc.hpp"
 #include "uci.hpp"
 #include "position.hpp"
@@ -10,6 +11,7 @@
 using namespace Stella;
 
 int main(int argc, char* argv[]) {
+    Cpu::init();
     Bitboards::init();
     Position::init();
     Features::init();
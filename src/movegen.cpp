@@ -95,6 +95,20 @@ Move Generator::next() {
             if (quietIdx < quiets.size) return next_best<QUIETS>();
             // Break out of loop once all evasions are searched
             break;
+
+        // Deferred moves are returned below
+        case DEFERRED_MOVES:
+            break;
+    }
+
+    // Once every stage is done, return the moves deferred by the search.
+    // Deferred quiets are dropped if quiets were skipped in the meantime,
+    // the same as they would have been had they not been deferred.
+    while (deferredIdx < deferred.size) {
+        Move m = deferred.moves[deferredIdx++];
+        if (skipQuiets && !pos->checks() && !pos->is_capture(m) && !pos->is_promotion(m)) continue;
+        generationStage = DEFERRED_MOVES;
+        return m;
     }
 
     // By default return Move::none() to know when no more moves are left
@@ -29,7 +29,8 @@ enum GenerationStage {
     BAD_CAPTURES,
     BAD_QUIETS,
     INIT_EVASIONS,
-    ALL_EVASIONS
+    ALL_EVASIONS,
+    DEFERRED_MOVES
 };
 
 enum GenerationMode {
@@ -52,6 +53,9 @@ private:
     MoveList captures;
     MoveList quiets;
     MoveList searched;
+    // Moves the search put off until all other moves are returned
+    MoveList deferred;
+    uint16_t deferredIdx = 0;
     // Store the killer moves for the position
     Move killer1;
     Move killer2;
@@ -103,6 +107,10 @@ public:
     Move next_best();
     // Add a move to the list of searched moves
     void add_searched(Move m);
+    // Put off a move until every other move has been returned
+    void defer(Move m);
+    // Check if the generator is returning deferred moves
+    bool is_deferring() const;
     // Get the searched movelist
     MoveList get_searched_list() const;
     // Return the sizes of the move lists
@@ -159,6 +167,14 @@ inline bool Generator::can_skip_quiets() const {
     return skipQuiets;
 }
 
+inline void Generator::defer(Move m) {
+    deferred.moves[deferred.size++] = m;
+}
+
+inline bool Generator::is_deferring() const {
+    return generationStage == DEFERRED_MOVES;
+}
+
 
 }
 
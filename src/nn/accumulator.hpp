@@ -4,6 +4,7 @@
 #include "../types.hpp"
 #include "common.hpp"
 #include "layers.hpp"
+#include "kernels.hpp"
 
 namespace Stella {
 
@@ -75,6 +76,10 @@ struct RefreshTable {
 // movements.
 struct AccumulatorTable {
     bool computed[COLOR_NB]{};
+    // Move leading to this entry, kept so the entry can be computed when needed
+    Move move = Move::none();
+    Piece piece = NO_PIECE;
+    Piece captured = NO_PIECE;
     alignas(BYTE_ALIGNMENT) int16_t values[COLOR_NB][Features::NB_L1]{};
     void reset(Position* pos);
     void refresh(Position* pos, Network::Evaluator* eval, Color side);
@@ -113,27 +118,9 @@ inline bool is_refresh_required(Piece pc, Square from, Square to) {
 // Function to apply delta to a given accumulator entry
 template<bool add>
 inline void apply_delta(int16_t* source, int16_t* target, const uint16_t idx) {
-    // Init the registers
-    vec_reg_16 rst[NB_REGISTER];
-
-    // Loop through each chunk
-    for (size_t i = 0; i < Features::NB_L1 / CHUNK_UNROLL; ++i) {
-        // Calculate an offset for this index
-        const size_t offset = i * CHUNK_UNROLL;
-
-        // Retrieve the weights, inputs and outputs
-        const auto weight = (vec_reg_16*) &Features::L0_WEIGHT[idx * Features::NB_L1 + offset];
-        const auto input = (vec_reg_16*) &source[offset];
-        auto output = (vec_reg_16*) &target[offset];
-
-        // Loop through registers and add/subtract the weights storing them in the output
-        for (size_t x = 0; x < NB_REGISTER; ++x) {
-            rst[x] = vec_load(&input[x]);
-            rst[x] = add ? vec_add_16(rst[x], weight[x])
-                         : vec_sub_16(rst[x], weight[x]);
-            vec_store(&output[x], rst[x]);
-        }
-    }
+    // Use the first layer weights of this thread's NUMA node
+    if (add) Kernels::active->add(source, target, Features::l0Weight, idx);
+    else     Kernels::active->sub(source, target, Features::l0Weight, idx);
 }
 
 template<bool add> inline void apply_delta(int16_t* source, const uint16_t index) {
@@ -145,98 +132,17 @@ template<bool add> inline void apply_delta(int16_t* source, const uint16_t index
 // and one add, then finally a castle which requires two subs and two adds.
 inline void sa(AccumulatorTable* source, AccumulatorTable* target, Color side,
                 uint16_t idx1, uint16_t idx2) {
-    // Init the registers
-    vec_reg_16 rst[NB_REGISTER];
-
-    // Get the in and out for the accumulators
-    const auto in = source->values[side];
-    const auto out = target->values[side];
-
-    // Loop through each chunk
-    for (int i = 0; i < Features::NB_L1 / CHUNK_UNROLL; ++i) {
-        // Calculate an offset for this index
-        const size_t offset = i * CHUNK_UNROLL;
-
-        // Retrieve the weights, inputs and outputs
-        auto weight1 = (vec_reg_16*) &Features::L0_WEIGHT[idx1 * Features::NB_L1 + offset];
-        auto weight2 = (vec_reg_16*) &Features::L0_WEIGHT[idx2 * Features::NB_L1 + offset];
-        auto input = (vec_reg_16*) &in[offset];
-        auto output = (vec_reg_16*) &out[offset];
-
-        // Loop through registers and add/subtract the weights storing them in the output
-        for (size_t x = 0; x < NB_REGISTER; ++x) {
-            rst[x] = vec_load(&input[x]);
-            rst[x] = vec_sub_16(rst[x], weight1[x]);
-            rst[x] = vec_add_16(rst[x], weight2[x]);
-            vec_store(&output[x], rst[x]);
-        }
-    }
+    Kernels::active->sa(source->values[side], target->values[side], Features::l0Weight, idx1, idx2);
 }
 
 inline void ssa(AccumulatorTable* source, AccumulatorTable* target, Color side,
                 uint16_t idx1, uint16_t idx2, uint16_t idx3) {
-    // Init the registers
-    vec_reg_16 rst[NB_REGISTER];
-
-    // Get the in and out for the accumulators
-    const auto in = source->values[side];
-    const auto out = target->values[side];
-
-    // Loop through each chunk
-    for (int i = 0; i < Features::NB_L1 / CHUNK_UNROLL; ++i) {
-        // Calculate an offset for this index
-        const size_t offset = i * CHUNK_UNROLL;
-
-        // Retrieve the weights, inputs and outputs
-        auto weight1 = (vec_reg_16*) &Features::L0_WEIGHT[idx1 * Features::NB_L1 + offset];
-        auto weight2 = (vec_reg_16*) &Features::L0_WEIGHT[idx2 * Features::NB_L1 + offset];
-        auto weight3 = (vec_reg_16*) &Features::L0_WEIGHT[idx3 * Features::NB_L1 + offset];
-        auto input = (vec_reg_16*) &in[offset];
-        auto output = (vec_reg_16*) &out[offset];
-
-        // Loop through registers and add/subtract the weights storing them in the output
-        for (size_t x = 0; x < NB_REGISTER; ++x) {
-            rst[x] = vec_load(&input[x]);
-            rst[x] = vec_sub_16(rst[x], weight1[x]);
-            rst[x] = vec_sub_16(rst[x], weight2[x]);
-            rst[x] = vec_add_16(rst[x], weight3[x]);
-            vec_store(&output[x], rst[x]);
-        }
-    }
+    Kernels::active->ssa(source->values[side], target->values[side], Features::l0Weight, idx1, idx2, idx3);
 }
 
 inline void ssaa(AccumulatorTable* source, AccumulatorTable* target, Color side,
                 uint16_t idx1, uint16_t idx2, uint16_t idx3, uint16_t idx4) {
-    // Init the registers
-    vec_reg_16 rst[NB_REGISTER];
-
-    // Get the in and out for the accumulators
-    const auto in = source->values[side];
-    const auto out = target->values[side];
-
-    // Loop through each chunk
-    for (int i = 0; i < Features::NB_L1 / CHUNK_UNROLL; ++i) {
-        // Calculate an offset for this index
-        const size_t offset = i * CHUNK_UNROLL;
-
-        // Retrieve the weights, inputs and outputs
-        auto weight1 = (vec_reg_16*) &Features::L0_WEIGHT[idx1 * Features::NB_L1 + offset];
-        auto weight2 = (vec_reg_16*) &Features::L0_WEIGHT[idx2 * Features::NB_L1 + offset];
-        auto weight3 = (vec_reg_16*) &Features::L0_WEIGHT[idx3 * Features::NB_L1 + offset];
-        auto weight4 = (vec_reg_16*) &Features::L0_WEIGHT[idx4 * Features::NB_L1 + offset];
-        auto input = (vec_reg_16*) &in[offset];
-        auto output = (vec_reg_16*) &out[offset];
-
-        // Loop through registers and add/subtract the weights storing them in the output
-        for (size_t x = 0; x < NB_REGISTER; ++x) {
-            rst[x] = vec_load(&input[x]);
-            rst[x] = vec_sub_16(rst[x], weight1[x]);
-            rst[x] = vec_sub_16(rst[x], weight2[x]);
-            rst[x] = vec_add_16(rst[x], weight3[x]);
-            rst[x] = vec_add_16(rst[x], weight4[x]);
-            vec_store(&output[x], rst[x]);
-        }
-    }
+    Kernels::active->ssaa(source->values[side], target->values[side], Features::l0Weight, idx1, idx2, idx3, idx4);
 }
 
 }
@@ -14,7 +14,8 @@ constexpr int NB_L2 = 1;
 }
 
 // Setup intrinsics based on computer,
-// this ensures that instructions fit into the CPU's registers
+// this ensures that instructions fit into the CPU's registers.
+// Only the kernels use these, see kernels.cpp.
 #if defined (__AVX512F__)
 using vec_reg_16 = __m512i;
 using vec_reg_32 = __m512i;
@@ -63,11 +64,14 @@ using vec_reg_32 = __m128i;
 #define NB_REGISTER 16
 #endif
 
-// Define the spacing and byte alignments
+// Define the spacing of the registers in use
 constexpr int INT16_SPACING = BIT_ALIGNMENT / 16;
-constexpr int BYTE_ALIGNMENT = BIT_ALIGNMENT / 8;
 constexpr int CHUNK_UNROLL = BIT_ALIGNMENT;
 
+// Network data is aligned for the widest registers whatever this file is
+// compiled for, so that kernels built for any instruction set can use it
+constexpr int BYTE_ALIGNMENT = 64;
+
 class Position;
 namespace Network {
 class Evaluator;
@@ -3,33 +3,10 @@
 #include "../position.hpp"
 #include "common.hpp"
 #include "layers.hpp"
-
-#include <emmintrin.h>
-#include <immintrin.h>
-#include <stdlib.h>
+#include "kernels.hpp"
 
 namespace Stella::Network {
 
-// Define a function for summing a 32 byte register
-inline int32_t sum_register_32(vec_reg_32& rst) {
-    #if defined(__AVX512F__)
-    const __m256i reduced8 = _mm256_add_epi32(_mm512_castsi512_si256(rst), _mm512_extracti32x8_epi32(rst, 1));
-    #elif defined(__AVX2__)
-    const __m256i reduced8 = rst;
-    #endif
-
-    #if defined(__AVX512F__) || defined(__AVX2__)
-    const __m128i reduced4 = _mm_add_epi32(_mm256_castsi256_si128(reduced8), _mm256_extractf128_si256(reduced8, 1));
-    #else
-    const __m128i reduced4 = rst;
-    #endif
-
-    __m128i vsum = _mm_add_epi32(reduced4, _mm_srli_si128(reduced4, 8));
-    vsum = _mm_add_epi32(vsum, _mm_srli_si128(vsum, 4));
-    int32_t sum = _mm_cvtsi128_si32(vsum);
-    return sum;
-}
-
 // Default constructor for evaluate
 Evaluator::Evaluator() {
     refreshTable = std::make_unique<Accumulator::RefreshTable>(Accumulator::RefreshTable{});
@@ -39,23 +16,9 @@ Evaluator::Evaluator() {
     historyIdx = 0;
 }
 
-// Copier for evaluate objects
-Evaluator::Evaluator(const Evaluator& e) {
-    history = e.history;
-    historyIdx = e.historyIdx;
-}
-
-// Assignment for evaluate objects
-Evaluator& Evaluator::operator=(const Evaluator& e) {
-    history = e.history;
-    historyIdx = e.historyIdx;
-    return *this;
-}
-
 // Reset the evaluator
 void Evaluator::reset(Position* pos) {
-    history.clear();
-    historyIdx = 0;
+    reset_history();
     history[historyIdx].reset(pos);
 }
 
@@ -67,7 +30,7 @@ void Evaluator::reset_history() {
 }
 
 template<bool undo>
-void Evaluator::update_history(Position* pos, Move m, Piece pc, Piece cap) {
+void Evaluator::update_history(Move m, Piece pc, Piece cap) {
     // If the move is an undo then pop back the history
     if (undo) {
         history[historyIdx].computed[WHITE] = false;
@@ -76,42 +39,61 @@ void Evaluator::update_history(Position* pos, Move m, Piece pc, Piece cap) {
         return;
     }
 
-    // Get the color of the piece
-    const Color side = piece_color(pc);
-
     // When not a history can increment forward and allocate a new entry
     historyIdx++;
     if (historyIdx >= history.size()) history.resize(historyIdx + 3);
 
-    // Loop through both sides
-    for (Color c : {WHITE, BLACK}) {
-        // Check if the move invokes a refresh
-        if (c == side && Accumulator::is_refresh_required(pc, m.from(), m.to()))
-            history[historyIdx].refresh(pos, this, c);
-        // Now check if last index is computed, if so we can lazily update from there
-        else if (history[historyIdx - 1].computed[c])
-            apply_lazy_updates(pos, c, m, pc, cap);
-        // Fallback onto a refresh in some cases
-        else
-            history[historyIdx].refresh(pos, this, c);
+    // Only record the move, many positions are left before they are evaluated
+    Accumulator::AccumulatorTable& entry = history[historyIdx];
+    entry.computed[WHITE] = false;
+    entry.computed[BLACK] = false;
+    entry.move = m;
+    entry.piece = pc;
+    entry.captured = cap;
+}
+
+template void Evaluator::update_history<true>(Move m, Piece pc, Piece cap);
+template void Evaluator::update_history<false>(Move m, Piece pc, Piece cap);
+
+void Evaluator::materialize(Position* pos, Color side) {
+    // Walk back to the nearest computed entry. A king move of this side that
+    // needs a refresh makes the entries before it unusable, so refresh instead.
+    uint32_t idx = historyIdx;
+    while (!history[idx].computed[side]) {
+        const Accumulator::AccumulatorTable& entry = history[idx];
+        if (idx == 0
+            || (piece_color(entry.piece) == side
+                && Accumulator::is_refresh_required(entry.piece, entry.move.from(), entry.move.to()))) {
+            history[historyIdx].refresh(pos, this, side);
+            return;
+        }
+        idx--;
+    }
+
+    // Apply the moves forward from the computed entry, the king of this side
+    // stays in the same bucket so the current king square can be used
+    for (++idx; idx <= historyIdx; ++idx) {
+        apply_lazy_updates(pos, side, idx);
+        history[idx].computed[side] = true;
     }
 }
 
-template void Evaluator::update_history<true>(Position* pos, Move m, Piece pc, Piece cap);
-template void Evaluator::update_history<false>(Position* pos, Move m, Piece pc, Piece cap);
+void Evaluator::apply_lazy_updates(Position* pos, Color side, uint32_t idx) {
+    // Get the move of this entry
+    const Move m = history[idx].move;
+    const Piece pc = history[idx].piece;
+    const Piece cap = history[idx].captured;
 
-void Evaluator::apply_lazy_updates(Position* pos, Color side, Move m, Piece pc, Piece cap) {
     // Get some info about the position
     const Square ksq = pos->ksq(side);
     const Color c = piece_color(pc);
-    uint32_t idx = historyIdx;
 
     // Get info about the move
     Square from = m.from();
     Square to = m.to();
 
     // Get the to piece in the case of a promotion can be tricky
-    Piece pcTo = pos->is_promotion(m) ? make_piece(c, m.promotion()) : pc;
+    Piece pcTo = m.type() == PROMOTION ? make_piece(c, m.promotion()) : pc;
 
     // Special case for castling, note captured piece is encoded as the rook here
     if (m.type() == CASTLING) {
@@ -151,31 +133,12 @@ void Evaluator::apply_lazy_updates(Position* pos, Color side, Move m, Piece pc,
 }
 
 Value Evaluator::propagate(Color side) {
-    // Init registers for relu
-    constexpr vec_reg_16 relu{};
-
     // Get the accumulator for each relative side
-    const auto us = (vec_reg_16*) &history[historyIdx].values[side];
-    const auto them = (vec_reg_16*) &history[historyIdx].values[~side];
-
-    // Create a register for the result
-    vec_reg_32 result{};
-
-    // Get the weights
-    const auto weight = (vec_reg_16*) Features::L1_WEIGHT;
-
-    // Loop through our side
-    for (int i = 0; i < Features::NB_L1 / INT16_SPACING; ++i) {
-        result = vec_add_32(result, vec_madd_16(vec_max_16(us[i], relu), weight[i]));
-    }
-    // Loop through their side, applying the offset
-    for (int i = 0; i < Features::NB_L1 / INT16_SPACING; ++i) {
-        int weightIdx = i + Features::NB_L1 / INT16_SPACING;
-        result = vec_add_32(result, vec_madd_16(vec_max_16(them[i], relu), weight[weightIdx]));
-    }
+    const int16_t* us = history[historyIdx].values[side];
+    const int16_t* them = history[historyIdx].values[~side];
 
-    // Sum over all the registers
-    const auto output = sum_register_32(result) + Features::L1_BIAS[0];
+    // Run the output layer with the kernels chosen for this cpu
+    const auto output = Kernels::active->propagate(us, them, Features::L1_WEIGHT) + Features::L1_BIAS[0];
     // Return the scaled output
     return output / 32 / 128;
 }
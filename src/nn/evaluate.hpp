@@ -15,21 +15,27 @@ public:
     std::unique_ptr<Accumulator::RefreshTable> refreshTable{};
     uint32_t historyIdx = 0;
 
-    // Constructors for evaluator to allocate memory
+    // Constructor for evaluator to allocate memory, each search thread owns
+    // one and lends it to the position it searches so it is never copied
     Evaluator();
-    Evaluator(const Evaluator& e);
-    Evaluator& operator=(const Evaluator& e);
+    Evaluator(const Evaluator& e) = delete;
+    Evaluator& operator=(const Evaluator& e) = delete;
 
     // Functions to reset the accumulator and history
     void reset(Position* pos);
     void reset_history();
 
-    // Function to update the accumulator with a move made
+    // Function to record a move made or undone, the accumulator of a new
+    // entry is only computed once the position is evaluated
     template<bool undo>
-    void update_history(Position* pos, Move m, Piece pc, Piece cap);
+    void update_history(Move m, Piece pc, Piece cap);
 
-    // Function for applying a lazy update of a given move
-    void apply_lazy_updates(Position* pos, Color side, Move m, Piece pc, Piece cap);
+    // Compute the accumulator of the current entry for a side, starting from
+    // the nearest computed entry or refreshing it if there is none to use
+    void materialize(Position* pos, Color side);
+
+    // Function for applying the move of an entry to the accumulator before it
+    void apply_lazy_updates(Position* pos, Color side, uint32_t idx);
 
     // Functions for evaluation
     Value predict(Position* pos);
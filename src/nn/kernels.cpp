@@ -0,0 +1,197 @@
+// Network kernels for a single instruction set. The makefile compiles this
+// file once for each instruction set it builds, with the matching compiler
+// flags, and names the namespace of each build with KERNEL_ISA. Nothing here
+// may be shared with other files, or the linker could pick a copy using
+// instructions the cpu does not have.
+
+#include "common.hpp"
+#include "kernels.hpp"
+
+#ifndef KERNEL_ISA
+#define KERNEL_ISA native
+#endif
+
+namespace Stella::Kernels::KERNEL_ISA {
+
+// Define a function for summing a 32 byte register
+static inline int32_t sum_register_32(vec_reg_32& rst) {
+    #if defined(__AVX512F__)
+    // The zero masked extracts avoid the undefined source register of the plain
+    // extract and cast, which gcc warns is uninitialized once they are inlined
+    const __m256i reduced8 = _mm256_add_epi32(_mm512_maskz_extracti64x4_epi64(0xFF, rst, 0),
+                                              _mm512_maskz_extracti64x4_epi64(0xFF, rst, 1));
+    #elif defined(__AVX2__)
+    const __m256i reduced8 = rst;
+    #endif
+
+    #if defined(__AVX512F__) || defined(__AVX2__)
+    const __m128i reduced4 = _mm_add_epi32(_mm256_castsi256_si128(reduced8), _mm256_extractf128_si256(reduced8, 1));
+    #else
+    const __m128i reduced4 = rst;
+    #endif
+
+    __m128i vsum = _mm_add_epi32(reduced4, _mm_srli_si128(reduced4, 8));
+    vsum = _mm_add_epi32(vsum, _mm_srli_si128(vsum, 4));
+    int32_t sum = _mm_cvtsi128_si32(vsum);
+    return sum;
+}
+
+// Function to apply delta to a given accumulator entry
+template<bool add>
+static void apply_delta(const int16_t* in, int16_t* out, const int16_t* weights, uint16_t idx) {
+    // Init the registers
+    vec_reg_16 rst[NB_REGISTER];
+
+    // Loop through each chunk
+    for (int i = 0; i < Features::NB_L1 / CHUNK_UNROLL; ++i) {
+        // Calculate an offset for this index
+        const size_t offset = i * CHUNK_UNROLL;
+
+        // Retrieve the weights, inputs and outputs
+        const auto weight = (const vec_reg_16*) &weights[idx * Features::NB_L1 + offset];
+        const auto input = (const vec_reg_16*) &in[offset];
+        auto output = (vec_reg_16*) &out[offset];
+
+        // Loop through registers and add/subtract the weights storing them in the output
+        for (int x = 0; x < NB_REGISTER; ++x) {
+            rst[x] = vec_load(&input[x]);
+            rst[x] = add ? vec_add_16(rst[x], weight[x])
+                         : vec_sub_16(rst[x], weight[x]);
+            vec_store(&output[x], rst[x]);
+        }
+    }
+}
+
+static void sa(const int16_t* in, int16_t* out, const int16_t* weights,
+               uint16_t idx1, uint16_t idx2) {
+    // Init the registers
+    vec_reg_16 rst[NB_REGISTER];
+
+    // Loop through each chunk
+    for (int i = 0; i < Features::NB_L1 / CHUNK_UNROLL; ++i) {
+        // Calculate an offset for this index
+        const size_t offset = i * CHUNK_UNROLL;
+
+        // Retrieve the weights, inputs and outputs
+        auto weight1 = (const vec_reg_16*) &weights[idx1 * Features::NB_L1 + offset];
+        auto weight2 = (const vec_reg_16*) &weights[idx2 * Features::NB_L1 + offset];
+        auto input = (const vec_reg_16*) &in[offset];
+        auto output = (vec_reg_16*) &out[offset];
+
+        // Loop through registers and add/subtract the weights storing them in the output
+        for (int x = 0; x < NB_REGISTER; ++x) {
+            rst[x] = vec_load(&input[x]);
+            rst[x] = vec_sub_16(rst[x], weight1[x]);
+            rst[x] = vec_add_16(rst[x], weight2[x]);
+            vec_store(&output[x], rst[x]);
+        }
+    }
+}
+
+static void ssa(const int16_t* in, int16_t* out, const int16_t* weights,
+                uint16_t idx1, uint16_t idx2, uint16_t idx3) {
+    // Init the registers
+    vec_reg_16 rst[NB_REGISTER];
+
+    // Loop through each chunk
+    for (int i = 0; i < Features::NB_L1 / CHUNK_UNROLL; ++i) {
+        // Calculate an offset for this index
+        const size_t offset = i * CHUNK_UNROLL;
+
+        // Retrieve the weights, inputs and outputs
+        auto weight1 = (const vec_reg_16*) &weights[idx1 * Features::NB_L1 + offset];
+        auto weight2 = (const vec_reg_16*) &weights[idx2 * Features::NB_L1 + offset];
+        auto weight3 = (const vec_reg_16*) &weights[idx3 * Features::NB_L1 + offset];
+        auto input = (const vec_reg_16*) &in[offset];
+        auto output = (vec_reg_16*) &out[offset];
+
+        // Loop through registers and add/subtract the weights storing them in the output
+        for (int x = 0; x < NB_REGISTER; ++x) {
+            rst[x] = vec_load(&input[x]);
+            rst[x] = vec_sub_16(rst[x], weight1[x]);
+            rst[x] = vec_sub_16(rst[x], weight2[x]);
+            rst[x] = vec_add_16(rst[x], weight3[x]);
+            vec_store(&output[x], rst[x]);
+        }
+    }
+}
+
+static void ssaa(const int16_t* in, int16_t* out, const int16_t* weights,
+                 uint16_t idx1, uint16_t idx2, uint16_t idx3, uint16_t idx4) {
+    // Init the registers
+    vec_reg_16 rst[NB_REGISTER];
+
+    // Loop through each chunk
+    for (int i = 0; i < Features::NB_L1 / CHUNK_UNROLL; ++i) {
+        // Calculate an offset for this index
+        const size_t offset = i * CHUNK_UNROLL;
+
+        // Retrieve the weights, inputs and outputs
+        auto weight1 = (const vec_reg_16*) &weights[idx1 * Features::NB_L1 + offset];
+        auto weight2 = (const vec_reg_16*) &weights[idx2 * Features::NB_L1 + offset];
+        auto weight3 = (const vec_reg_16*) &weights[idx3 * Features::NB_L1 + offset];
+        auto weight4 = (const vec_reg_16*) &weights[idx4 * Features::NB_L1 + offset];
+        auto input = (const vec_reg_16*) &in[offset];
+        auto output = (vec_reg_16*) &out[offset];
+
+        // Loop through registers and add/subtract the weights storing them in the output
+        for (int x = 0; x < NB_REGISTER; ++x) {
+            rst[x] = vec_load(&input[x]);
+            rst[x] = vec_sub_16(rst[x], weight1[x]);
+            rst[x] = vec_sub_16(rst[x], weight2[x]);
+            rst[x] = vec_add_16(rst[x], weight3[x]);
+            rst[x] = vec_add_16(rst[x], weight4[x]);
+            vec_store(&output[x], rst[x]);
+        }
+    }
+}
+
+static int32_t propagate(const int16_t* usValues, const int16_t* themValues, const int16_t* weights) {
+    // Init registers for relu
+    const vec_reg_16 relu{};
+
+    // Get the accumulator for each relative side
+    const auto us = (const vec_reg_16*) usValues;
+    const auto them = (const vec_reg_16*) themValues;
+
+    // Create a register for the result
+    vec_reg_32 result{};
+
+    // Get the weights
+    const auto weight = (const vec_reg_16*) weights;
+
+    // Loop through our side
+    for (int i = 0; i < Features::NB_L1 / INT16_SPACING; ++i) {
+        result = vec_add_32(result, vec_madd_16(vec_max_16(us[i], relu), weight[i]));
+    }
+    // Loop through their side, applying the offset
+    for (int i = 0; i < Features::NB_L1 / INT16_SPACING; ++i) {
+        int weightIdx = i + Features::NB_L1 / INT16_SPACING;
+        result = vec_add_32(result, vec_madd_16(vec_max_16(them[i], relu), weight[weightIdx]));
+    }
+
+    // Sum over all the registers
+    return sum_register_32(result);
+}
+
+// Name the kernels after the widest registers this build uses
+#if defined(__AVX512F__)
+#define KERNEL_NAME "avx512"
+#elif defined(__AVX2__)
+#define KERNEL_NAME "avx2"
+#else
+#define KERNEL_NAME "sse"
+#endif
+
+extern const KernelSet kernels;
+const KernelSet kernels = {
+    KERNEL_NAME,
+    apply_delta<true>,
+    apply_delta<false>,
+    sa,
+    ssa,
+    ssaa,
+    propagate
+};
+
+}
@@ -0,0 +1,36 @@
+#ifndef KERNELS_H_INCLUDED
+#define KERNELS_H_INCLUDED
+
+#include <cstdint>
+
+namespace Stella::Kernels {
+
+// Table of the network kernels built for one instruction set. The kernels
+// work on accumulators and weights aligned to BYTE_ALIGNMENT, and the
+// input and output accumulator of an update may be the same.
+struct KernelSet {
+    // Name of the instruction set the kernels were built for
+    const char* name;
+
+    // Add or subtract the weights of a single feature
+    void (*add)(const int16_t* in, int16_t* out, const int16_t* weights, uint16_t idx);
+    void (*sub)(const int16_t* in, int16_t* out, const int16_t* weights, uint16_t idx);
+
+    // Subtract and add the features changed by quiet moves, captures and castling
+    void (*sa)(const int16_t* in, int16_t* out, const int16_t* weights,
+               uint16_t sub1, uint16_t add1);
+    void (*ssa)(const int16_t* in, int16_t* out, const int16_t* weights,
+                uint16_t sub1, uint16_t sub2, uint16_t add1);
+    void (*ssaa)(const int16_t* in, int16_t* out, const int16_t* weights,
+                 uint16_t sub1, uint16_t sub2, uint16_t add1, uint16_t add2);
+
+    // Sum of the clipped accumulators of both sides times the output weights
+    int32_t (*propagate)(const int16_t* us, const int16_t* them, const int16_t* weights);
+};
+
+// Kernels chosen for this cpu, set by Cpu::init before anything is evaluated
+extern const KernelSet* active;
+
+}
+
+#endif
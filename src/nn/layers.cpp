@@ -1,5 +1,9 @@
 #include "layers.hpp"
 #include "../incbin/incbin.h"
+#include "../types.hpp"
+
+#include <mutex>
+#include <vector>
 
 // Define the incbin style
 #define INCBIN_STYLE INCBIN_STYLE_CAMEL
@@ -15,6 +19,30 @@ alignas(BYTE_ALIGNMENT) int16_t L0_BIAS[NB_L1];
 alignas(BYTE_ALIGNMENT) int16_t L1_WEIGHT[NB_L1 * 2];
 alignas(BYTE_ALIGNMENT) int32_t L1_BIAS[NB_L2];
 
+// Threads use the shared weights until given a node local copy
+thread_local int16_t* l0Weight = L0_WEIGHT;
+
+// Copies of the first layer weights for each NUMA node, these live
+// for the lifetime of the program once created
+static std::vector<int16_t*> nodeWeights;
+static std::mutex nodeWeightsMutex;
+
+int16_t* node_weights(int node) {
+    std::lock_guard<std::mutex> lock(nodeWeightsMutex);
+
+    if (node >= static_cast<int>(nodeWeights.size()))
+        nodeWeights.resize(node + 1, nullptr);
+
+    // Copy the weights from this thread so that the pages are first
+    // touched, and so allocated, on the node the thread is bound to
+    if (!nodeWeights[node]) {
+        nodeWeights[node] = static_cast<int16_t*>(aligned_malloc(BYTE_ALIGNMENT, sizeof(L0_WEIGHT)));
+        std::memcpy(nodeWeights[node], L0_WEIGHT, sizeof(L0_WEIGHT));
+    }
+
+    return nodeWeights[node];
+}
+
 // Define the initializer
 void init() {
     // Keep track of the current index
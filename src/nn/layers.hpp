@@ -11,6 +11,15 @@ extern int16_t L0_BIAS[NB_L1];
 extern int16_t L1_WEIGHT[NB_L1 * 2];
 extern int32_t L1_BIAS[NB_L2];
 
+// First layer weights used by the calling thread. Points to L0_WEIGHT unless
+// the thread was given a copy local to its NUMA node.
+extern thread_local int16_t* l0Weight;
+
+// Get the copy of the first layer weights for a NUMA node, creating it on
+// first use. The copy is written by the calling thread, so it must already
+// be bound to the node for the pages to be placed there.
+int16_t* node_weights(int node);
+
 // Initializer for all the network layers
 void init();
 
@@ -163,6 +163,9 @@ Position::Position(const std::string& fen, bool chess960) {
             pc = Piece(pieceChar.find(token));
             // For each set piece adjust the hash key
             current->key ^= Zobrist::pieces[pc][s];
+            // Pawns and other pieces also have their own keys
+            if (piece_type(pc) == PAWN) current->pawnKey ^= Zobrist::pieces[pc][s];
+            else current->nonPawnKey[piece_color(pc)] ^= Zobrist::pieces[pc][s];
             set_piece(pc, s);
             ++s;
             // Also add the value of the piece if it is not a pawn or king
@@ -229,9 +232,6 @@ Position::Position(const std::string& fen, bool chess960) {
     // Set if position is Chess960
     this->isChess960 = chess960;
 
-    // Reset the accumulator histories
-    network.reset(this);
-
     // Finally update the game state
     this->update();
 }
@@ -261,8 +261,8 @@ Position& Position::operator=(const Position& pos) {
 
     this->current = &this->positionHistory.back();
 
-    // Reset the accumulator
-    network.reset(this);
+    // Reset the accumulator if this position already has an evaluator
+    if (network) network->reset(this);
 
     // Update the state info
     this->update();
@@ -606,6 +606,10 @@ void Position::do_move(Move m) {
 
     // Update the new state with the old one
     current->key = previous.key;
+    current->pawnKey = previous.pawnKey;
+    std::copy(std::begin(previous.nonPawnKey),
+              std::end(previous.nonPawnKey),
+              std::begin(current->nonPawnKey));
     current->castlingRights = previous.castlingRights;
     current->fiftyRule = previous.fiftyRule;
     current->pliesFromNull = previous.pliesFromNull;
@@ -670,6 +674,10 @@ void Position::do_move(Move m) {
                       ^ Zobrist::pieces[pc][kingTo]
                       ^ Zobrist::pieces[make_piece(us, ROOK)][rookFrom] 
                       ^ Zobrist::pieces[make_piece(us, ROOK)][rookTo];
+        current->nonPawnKey[us] ^= Zobrist::pieces[pc][kingFrom]
+                                 ^ Zobrist::pieces[pc][kingTo]
+                                 ^ Zobrist::pieces[make_piece(us, ROOK)][rookFrom]
+                                 ^ Zobrist::pieces[make_piece(us, ROOK)][rookTo];
 
         // Set the captured piece to the castling rook
         captured = us == WHITE ? W_ROOK : B_ROOK;
@@ -704,8 +712,12 @@ void Position::do_move(Move m) {
         current->fiftyRule = 0;
         // Update the zobrist key
         current->key ^= Zobrist::pieces[captured][captureSq];
-        // Update non pawn material
-        if (piece_type(captured) != PAWN) current->nonPawnMaterial[them] -= piece_value(captured);
+        // Update non pawn material and the pawn or non pawn key
+        if (piece_type(captured) != PAWN) {
+            current->nonPawnMaterial[them] -= piece_value(captured);
+            current->nonPawnKey[them] ^= Zobrist::pieces[captured][captureSq];
+        }
+        else current->pawnKey ^= Zobrist::pieces[captured][captureSq];
 
     }
 
@@ -727,6 +739,8 @@ void Position::do_move(Move m) {
     if (type != CASTLING) {
         move_piece(from, to);
         current->key ^= Zobrist::pieces[pc][from] ^ Zobrist::pieces[pc][to];
+        if (piece_type(pc) == PAWN) current->pawnKey ^= Zobrist::pieces[pc][from] ^ Zobrist::pieces[pc][to];
+        else current->nonPawnKey[us] ^= Zobrist::pieces[pc][from] ^ Zobrist::pieces[pc][to];
     }
 
     // Handle pawn moves, this includes promotions
@@ -751,6 +765,8 @@ void Position::do_move(Move m) {
 
             // Update the zobrist key now to account for new piece on to square
             current->key ^= Zobrist::pieces[pc][to] ^ Zobrist::pieces[promotion][to];
+            current->pawnKey ^= Zobrist::pieces[pc][to];
+            current->nonPawnKey[us] ^= Zobrist::pieces[promotion][to];
 
             // Update non pawn material with the promoted piece
             current->nonPawnMaterial[us] += piece_value(promotion);
@@ -769,8 +785,11 @@ void Position::do_move(Move m) {
     // Update the hash key for the current side
     current->key ^= Zobrist::side;
 
-    // Prefetch hashtable entry
-    if (prefetch) table.prefetch(current->key);
+    // Prefetch hashtable and eval cache entries
+    if (prefetch) {
+        table.prefetch(current->key);
+        if (evalCache) evalCache->prefetch(current->key);
+    }
 
     // Update state information
     update();
@@ -780,7 +799,7 @@ void Position::do_move(Move m) {
     if (!lazy) return;
 
     // Update the accumulator
-    network.update_history<false>(this, m, pc, captured);
+    if (network) network->update_history<false>(m, pc, captured);
 
     // Ensure reptition is false
     current->repetition = 0;
@@ -900,7 +919,7 @@ void Position::undo_move(Move m) {
     }
 
     // Pop back the accumulator history
-    if (lazy) network.update_history<true>(this, m, NO_PIECE, NO_PIECE);
+    if (lazy && network) network->update_history<true>(m, NO_PIECE, NO_PIECE);
 
     // Remove the state and adjust the current pointer
     positionHistory.pop_back();
@@ -920,6 +939,10 @@ void Position::do_null() {
 
     // Update the new state with the old one
     current->key = previous.key;
+    current->pawnKey = previous.pawnKey;
+    std::copy(std::begin(previous.nonPawnKey),
+              std::end(previous.nonPawnKey),
+              std::begin(current->nonPawnKey));
     current->castlingRights = previous.castlingRights;
     current->fiftyRule = previous.fiftyRule;
     current->pliesFromNull = 0;
@@ -1162,8 +1185,15 @@ constexpr float eval_eg_scale = 1.15;
 constexpr float phase_sum = 39.6684;
 
 Value Position::evaluate() {
-    // Get the score from the network
-    Value score = network.propagate(side());
+    // Use the cached score if this position was evaluated recently
+    Value cached;
+    if (evalCache && evalCache->probe(current->key, cached)) return cached;
+
+    // Bring the accumulators up to date, then get the score from the network
+    assert(network);
+    network->materialize(this, WHITE);
+    network->materialize(this, BLACK);
+    Value score = network->propagate(side());
 
     // Calculate the phase
     float phase = (phase_sum
@@ -1173,8 +1203,11 @@ Value Position::evaluate() {
                   - phaseValues[ROOK] * popcount(pieces(ROOK))
                   - phaseValues[QUEEN] * popcount(pieces(QUEEN))) / phase_sum;
 
-    // Return the scaled eval
-    return std::clamp(static_cast<Value>((eval_mg_scale - phase * (eval_mg_scale - eval_eg_scale)) * score), VALUE_LOSS_MAX_PLY + 1, VALUE_WIN_MAX_PLY - 1);
+    // Scale the eval and store it in the cache
+    Value scaled = std::clamp(static_cast<Value>((eval_mg_scale - phase * (eval_mg_scale - eval_eg_scale)) * score), VALUE_LOSS_MAX_PLY + 1, VALUE_WIN_MAX_PLY - 1);
+    if (evalCache) evalCache->save(current->key, scaled);
+
+    return scaled;
 }
 
 }
@@ -6,6 +6,7 @@
 
 #include "bitboard.hpp"
 #include "types.hpp"
+#include "evalcache.hpp"
 #include "nn/evaluate.hpp"
 
 namespace Stella {
@@ -14,6 +15,8 @@ namespace Stella {
 // Most of this information is important in restoring a previous position.
 struct PositionInfo {
     Key       key = 0;
+    Key       pawnKey = 0;
+    Key       nonPawnKey[COLOR_NB] = {0};
     int       castlingRights = 0;
     int       fiftyRule = 0;
     int       pliesFromNull = 0;
@@ -53,8 +56,10 @@ private:
     // Also store a pointer to the current position
     PositionInfo* current;
 
-    // Store the evaluator
-    Network::Evaluator network;
+    // Evaluator and eval cache of the search thread using this position, if any.
+    // They are borrowed so copying a position does not copy the accumulators.
+    Network::Evaluator* network = nullptr;
+    EvalCache* evalCache = nullptr;
 
     // Updates the position for checks, pins and blockers
     void update();
@@ -68,6 +73,10 @@ public:
 
     // Evaluate the position using the neural net
     Value evaluate();
+    // Set the evaluator and eval cache used by evaluate, they are not copied
+    // with the position. Setting the evaluator resets its accumulators.
+    void set_evaluator(Network::Evaluator* evaluator);
+    void set_eval_cache(EvalCache* cache);
 
     // Constructors using FEN "Forsyth–Edwards Notation",
     // if Chess960 is used then Shredder-FEN or X-FEN will be used over standard FEN.
@@ -113,6 +122,8 @@ public:
 
     // Retrieve information about the current gamestate.
     Key            key() const;
+    Key            pawn_key() const;
+    Key            non_pawn_key(Color c) const;
     CastlingRights castling_rights(Color c) const;
     int            fifty_rule() const;
     int            plies_from_null() const;
@@ -191,10 +202,27 @@ public:
 // Create an operator to send position to a stream
 std::ostream& operator<<(std::ostream& os, const Position& pos);
 
+inline void Position::set_evaluator(Network::Evaluator* evaluator) {
+    network = evaluator;
+    if (network) network->reset(this);
+}
+
+inline void Position::set_eval_cache(EvalCache* cache) {
+    evalCache = cache;
+}
+
 inline Key Position::key() const {
     return current->key;
 }
 
+inline Key Position::pawn_key() const {
+    return current->pawnKey;
+}
+
+inline Key Position::non_pawn_key(Color c) const {
+    return current->nonPawnKey[c];
+}
+
 inline PositionInfo Position::previous() const {
     return previous(1);
 }
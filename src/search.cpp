@@ -2,6 +2,8 @@
 #include "position.hpp"
 #include "types.hpp"
 #include "movegen.hpp"
+#include "topology.hpp"
+#include "nn/layers.hpp"
 
 #include <thread>
 #include <cmath>
@@ -9,12 +11,45 @@
 
 namespace Stella {
 
-void update_continuation_histories(Position* pos, History* hist, 
-                                   int ply, Piece pc, Square to, int bonus);
+void update_continuation_histories(History* hist, int ply, bool inCheck,
+                                   Piece pc, Square to, int bonus);
 void update_quiet_stats(Position* pos, History* hist, int ply, Move m, int bonus);
 void update_history(Position* pos, History* hist, Generator* gen, 
                     int ply, Move best, int depth);
 
+// ABDADA table of moves currently being searched. Each slot holds a key made
+// from the position and the move, set by the thread searching it so that
+// other threads can defer the same move at non-pv nodes.
+constexpr int ABDADA_SIZE = 1 << 15;
+constexpr Depth ABDADA_DEPTH = 3;
+static std::atomic<Key> abdadaTable[ABDADA_SIZE];
+
+// Key of a move made in a position
+static inline Key move_key(Key key, Move m) {
+    return key ^ (m.data() * 0x9E3779B97F4A7C15ULL);
+}
+
+static inline std::atomic<Key>& abdada_slot(Key moveKey) {
+    return abdadaTable[moveKey & (ABDADA_SIZE - 1)];
+}
+
+// Check if another thread is searching this move
+static inline bool abdada_searching(Key moveKey) {
+    return abdada_slot(moveKey).load(std::memory_order_relaxed) == moveKey;
+}
+
+// Mark a move as being searched if its slot is free, returns true if marked
+static inline bool abdada_mark(Key moveKey) {
+    Key empty = 0;
+    return abdada_slot(moveKey).compare_exchange_strong(empty, moveKey, std::memory_order_relaxed);
+}
+
+// Clear the mark of a move, only if it was not taken over by another move
+static inline void abdada_unmark(Key moveKey) {
+    Key expected = moveKey;
+    abdada_slot(moveKey).compare_exchange_strong(expected, 0, std::memory_order_relaxed);
+}
+
 // Define constructor for setting thread using default constructor.
 SearchData::SearchData(int id) : threadId(id) {}
 // Default constructor
@@ -23,23 +58,47 @@ SearchData::SearchData() {}
 // Clear SearchData
 template<bool full>
 void SearchData::clear() {
-    if (full) hist.clear();
+    if (full) {
+        hist.clear();
+        evalCache.clear();
+    }
+    evalCache.reset_stats();
     pvTable.reset();
     ply = 0;
     rootDepth = 0;
-    nodes = 0;
-    selDepth = 0;
+    nodes.store(0, std::memory_order_relaxed);
+    selDepth.store(0, std::memory_order_relaxed);
     nmpMinPly = 0;
     stop = false;
+    completedDepth = 0;
     score = -VALUE_INFINITE;
+    completedScore = -VALUE_INFINITE;
+    completedMove = Move::none();
+    completedPv.reset();
+    pvIdx = 0;
     bestMove = Move::none();
     extMove = Move::none();
 }
 
 template<Bound bound>
-void Search::print_info_string() {
+void Search::print_info_string(const SearchData* sd) {
     assert(threadCount && threadData.size());
 
+    // With several pv lines, print every line once an iteration completes
+    if (!bound && multiPV > 1) {
+        int lines = std::min(multiPV, static_cast<int>(sd->rootMoves.size()));
+
+        for (int i = 0; i < lines; ++i) {
+            const RootMove& rm = sd->rootMoves[i];
+            print_pv_line(BOUND_NONE, i + 1, sd->rootDepth, rm.pvScore, rm.pv, rm.m);
+        }
+    }
+
+    // Otherwise information is retrieved from the line being searched
+    else print_pv_line(bound, sd->pvIdx + 1, sd->rootDepth, sd->score, sd->pvTable[0], sd->bestMove);
+}
+
+void Search::print_pv_line(Bound bound, int line, Depth depth, Value score, const PvLine& pv, Move best) {
     // Get elapsed time
     int elapsed = tm->elapsed();
 
@@ -47,18 +106,16 @@ void Search::print_info_string() {
     uint64_t nodes = total_nodes();
     Depth seldepth = max_seldepth();
 
-    // Rest of information is retrieved from main thread
-    SearchData* mainThread = &threadData[0];
-    Depth depth = mainThread->rootDepth;
-    Value score = mainThread->score;
-    PvLine pv = mainThread->pvTable[0];
-
     // Calculate the nodes per second
     uint64_t nps = (nodes * 1000) / (elapsed + 1);
 
     // Print the information
     std::cout << "info" << " depth " << depth << " seldepth " << seldepth;
 
+    // Print the line number when searching several lines
+    if (multiPV > 1)
+        std::cout << " multipv " << line;
+
     // Convert the score to Uci format
     if (std::abs(score) >= VALUE_MATE_IN_MAX_PLY)
         std::cout << " score mate " << (VALUE_MATE - std::abs(score) + 1) / 2
@@ -77,7 +134,7 @@ void Search::print_info_string() {
     if (pv.size)
         for (int i = 0; i < pv.size; i++) std::cout << " " << from_move(pv.moves[i], chess960);
     else
-        std::cout << " " << from_move(mainThread->bestMove, chess960);
+        std::cout << " " << from_move(best, chess960);
 
     // End with a newline
     std::cout << std::endl;
@@ -87,15 +144,78 @@ void Search::print_info_string() {
 uint64_t Search::total_nodes() const {
     uint64_t result = 0;
     for (auto& data : threadData)
-        result += data.nodes;
+        result += data->node_count();
     return result;
 }
 
+// Pick the thread to take the best move from. Each thread votes for the move
+// of its last completed iteration, weighted by how far the score is above the
+// worst thread and by the depth it completed, so deeper and more confident
+// results win out. Moves of iterations cut off by the stop take no part.
+SearchData* Search::best_thread() {
+    SearchData* best = threadData[0].get();
+
+    // With several pv lines the main thread's ranking is kept
+    if (threadCount == 1 || multiPV > 1) return best;
+
+    Value minScore = VALUE_INFINITE;
+    for (auto& data : threadData)
+        if (data->completedDepth)
+            minScore = std::min(minScore, data->completedScore);
+
+    // Sum the votes for the move chosen by a given thread
+    auto votes = [&](const SearchData& candidate) {
+        int64_t result = 0;
+        for (auto& data : threadData)
+            if (data->completedDepth && data->completedMove == candidate.completedMove)
+                result += int64_t(data->completedScore - minScore + 14) * data->completedDepth;
+        return result;
+    };
+
+    int64_t bestVotes = votes(*best);
+
+    for (auto& data : threadData) {
+        // Threads that never finished an iteration have nothing to vote with
+        if (!data->completedDepth) continue;
+
+        // A proven win is always preferred, taking the quickest one
+        if (is_win(best->completedScore) || is_win(data->completedScore)) {
+            if (data->completedScore > best->completedScore) best = data.get();
+            continue;
+        }
+
+        int64_t v = votes(*data);
+        if (v > bestVotes || (v == bestVotes && data->completedDepth > best->completedDepth)) {
+            best = data.get();
+            bestVotes = v;
+        }
+    }
+
+    return best;
+}
+
+// Check the search limits, called once per node. The clock is only read by the
+// main thread every 1024 nodes, while the node limit is checked by every thread
+// against the total of all threads every 64 nodes so the overshoot is bounded
+// by 64 nodes per thread.
+bool Search::limits_reached(SearchData* sd) {
+    uint64_t nodes = sd->node_count();
+
+    if (tm->nodeLimit.enabled
+        && nodes % 64 == 0
+        && total_nodes() >= tm->nodeLimit.max)
+        return true;
+
+    return nodes % 1024 == 0
+        && sd->threadId == 0
+        && !tm->can_continue();
+}
+
 // Utility function to retrieve max seldepth
 Depth Search::max_seldepth() const {
     Depth result = 0;
     for (auto& data : threadData)
-        result = std::max(data.selDepth, result);
+        result = std::max(data->sel_depth(), result);
     return result;
 }
 
@@ -105,23 +225,166 @@ void Search::set_threads(int num) {
     int maxThreads = std::max(static_cast<uint32_t>(1),
                      std::thread::hardware_concurrency());
 
+    // Close the current pool so no thread holds on to old data
+    close_pool();
+
     // Set the maximum from the argument given
     threadCount = std::clamp(num, 1, maxThreads);
 
     // Clear any old thread data
     threadData.clear();
 
-    // Create the new threads
+    // Create the new thread data
+    for (int i = 0; i < threadCount; ++i) {
+        threadData.emplace_back(std::make_unique<SearchData>(i));
+    }
+
+    launch_pool();
+}
+
+// Launch the threads, they stay parked until a search wakes them
+void Search::launch_pool() {
+    searching.assign(threadCount, false);
+    exitPool = false;
+
     for (int i = 0; i < threadCount; ++i) {
-        threadData.emplace_back(SearchData(i));
+        threads.emplace_back(&Search::idle_loop, this, i);
     }
 }
 
+// Set the cpus search threads are pinned to, given a policy understood by
+// Topology::placement or "none" to leave placement to the OS. Returns false
+// and keeps the current placement if the policy gives no cpus.
+bool Search::set_affinity(const std::string& policy) {
+    std::vector<int> cpus = policy == "none" ? std::vector<int>() : Topology::placement(policy);
+
+    if (policy != "none" && cpus.empty()) return false;
+
+    affinity = cpus;
+
+    // Restart the pool so every thread is created with the new placement
+    close_pool();
+    launch_pool();
+
+    return true;
+}
+
+Search::~Search() {
+    close_pool();
+}
+
+// Depth schedule for helper threads, each helper takes a row by its id and
+// searches depths in blocks of the given size with the given phase offset,
+// skipping every other block.
+constexpr int SKIP_SCHEDULE = 20;
+constexpr int SkipSize[SKIP_SCHEDULE]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+constexpr int SkipPhase[SKIP_SCHEDULE] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+bool Search::skip_depth(int id, Depth depth) const {
+    int row = (id - 1) % SKIP_SCHEDULE;
+    return ((depth + SkipPhase[row]) / SkipSize[row]) % 2;
+}
+
+// Enable or disable NUMA replication of the network weights. Returns the number
+// of nodes threads are spread over, replication only happens with more than one.
+int Search::set_numa(bool enabled) {
+    numaNodes = enabled ? Topology::nodes() : std::vector<std::vector<int>>();
+
+    // Restart the pool so every thread is bound to its node
+    close_pool();
+    launch_pool();
+
+    return numaNodes.size();
+}
+
+// Loop each pool thread runs for its lifetime, it sleeps until its
+// flag is set, searches and then signals that it is idle again
+void Search::idle_loop(int id) {
+    // Pin the thread to its cpu before it ever searches
+    int cpu = affinity.empty() ? -1 : affinity[id % affinity.size()];
+    if (cpu >= 0)
+        Topology::pin_thread(cpu);
+
+    // With several NUMA nodes, bind the thread to a node, either the node of
+    // its pinned cpu or spreading threads over the nodes in turn, and point
+    // it at that node's copy of the network weights
+    if (numaNodes.size() > 1) {
+        int node = cpu >= 0 ? Topology::node_of(cpu, numaNodes) : id % numaNodes.size();
+
+        if (node >= 0) {
+            if (cpu < 0) Topology::pin_thread(numaNodes[node]);
+            Features::l0Weight = Features::node_weights(node);
+        }
+    }
+
+    while (true) {
+        std::unique_lock<std::mutex> lock(poolMutex);
+        poolCv.wait(lock, [&] { return searching[id] || exitPool; });
+
+        if (exitPool) return;
+
+        lock.unlock();
+        if (poolTask) (*poolTask)(id, threadCount);
+        else iterative_deepening(id);
+        lock.lock();
+
+        searching[id] = false;
+        poolCv.notify_all();
+    }
+}
+
+void Search::run_on_threads(const std::function<void(int, int)>& task) {
+    wait(0, threadCount - 1);
+
+    poolTask = &task;
+    wake(0, threadCount - 1);
+    wait(0, threadCount - 1);
+    poolTask = nullptr;
+}
+
+// Set the search flag for threads first to last (inclusive) and wake them
+void Search::wake(int first, int last) {
+    std::lock_guard<std::mutex> lock(poolMutex);
+
+    for (int i = first; i <= last; ++i)
+        searching[i] = true;
+
+    poolCv.notify_all();
+}
+
+// Block until threads first to last (inclusive) are idle
+void Search::wait(int first, int last) {
+    std::unique_lock<std::mutex> lock(poolMutex);
+
+    poolCv.wait(lock, [&] {
+        for (int i = first; i <= last; ++i)
+            if (searching[i]) return false;
+        return true;
+    });
+}
+
+// Tell all threads to exit once idle and join them
+void Search::close_pool() {
+    if (threads.empty()) return;
+
+    wait(0, threadCount - 1);
+
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        exitPool = true;
+        poolCv.notify_all();
+    }
+
+    for (auto& thread : threads) thread.join();
+
+    threads.clear();
+}
+
 // Clear the thread data, this is usually called when starting a new game
 void Search::clear_thread_data() {
     // Loop through each thread
     for (auto& thread : threadData) {
-        thread.clear<true>();
+        thread->clear<true>();
     }
 }
 
@@ -146,24 +409,63 @@ int stat_malus(int depth) {
     return std::min(350 * depth - 200, 1700);
 }
 
-// Main search function called from Uci.
-// Sets up threads and calls them to run alpha beta function.
-// Returns the best move found from the search, starts and stops all threads.
-Move Search::search(Position* pos, TimeManager* manager, int id) {
+// Start a search in the background on the pool's main thread.
+// The best move is printed by the main thread once the search finishes.
+void Search::start(Position* pos, TimeManager* manager) {
+    assert(pos);
+    assert(manager);
+
+    // Make sure no search is still running
+    wait(0, 0);
+
+    // Set the root position and time manager for the search
+    rootPos = pos;
+    tm = manager;
+    printBestMove = true;
+
+    // Set the manager defaults before waking the thread, a stop
+    // sent right after this must not be overwritten
+    tm->forceStop.store(false, std::memory_order_relaxed);
+
+    wake(0, 0);
+}
+
+// Wait for the main thread to finish a search started in the background
+void Search::wait_for_search() {
+    wait(0, 0);
+}
+
+// Run a search and return the best move found, used when the
+// caller needs the result directly such as for benchmarks
+Move Search::search(Position* pos, TimeManager* manager) {
     assert(pos);
     assert(manager);
 
+    wait(0, 0);
+
+    rootPos = pos;
+    tm = manager;
+    printBestMove = false;
+    tm->forceStop.store(false, std::memory_order_relaxed);
+
+    wake(0, 0);
+    wait(0, 0);
+
+    return resultMove;
+}
+
+// Main search function run by every thread in the pool.
+// The main thread sets up the search and wakes all other threads to run
+// alpha beta alongside it, then stops them once it is finished.
+void Search::iterative_deepening(int id) {
     // Check if is main thread
     bool mainThread = id == 0;
 
-    // Set the manager defaults
-    manager->forceStop = false;
-
     // Setup the search depth if given, otherwise set it to a maximum
     Depth maxDepth = MAX_PLY - 1;
 
-    if (manager->depthLimit.enabled)
-        maxDepth = std::min(maxDepth, static_cast<Depth>(manager->depthLimit.max));
+    if (tm->depthLimit.enabled)
+        maxDepth = std::min(maxDepth, static_cast<Depth>(tm->depthLimit.max));
 
     // If this function is called from the main thread, then initialize
     // all other threads and setup any needed parameters
@@ -171,134 +473,268 @@ Move Search::search(Position* pos, TimeManager* manager, int id) {
         // Set a new search for the transposition table
         table.new_search();
         // Set chess960 flag
-        chess960 = pos->is_chess960();
+        chess960 = rootPos->is_chess960();
 
         // Store all the root moves
-        Generator gen(pos);
+        Generator gen(rootPos);
         Move m;
 
         // Clear old root moves
-        rootMoves.clear();
+        std::vector<RootMove> rootMoves;
 
-        // Loop through the moves
+        // Loop through the moves, keeping only the requested ones if
+        // the search was restricted with searchmoves
         while ((m = gen.next_best<LEGAL>()) != Move::none())
-            rootMoves.emplace_back(RootMove(m));
+            if (tm->searchMoves.empty()
+                || std::find(tm->searchMoves.begin(), tm->searchMoves.end(), m) != tm->searchMoves.end())
+                rootMoves.emplace_back(RootMove(m));
+
+        // Without legal moves there is nothing to search, so report the mate
+        // or stalemate score with a null best move and leave the helpers idle
+        if (rootMoves.empty()) {
+            resultMove = Move::none();
+
+            if (printBestMove) {
+                while (tm->pondering() && !tm->stopped())
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+                std::cout << "info depth 0 score "
+                          << (rootPos->checks() ? "mate 0" : "cp 0")
+                          << std::endl
+                          << "bestmove 0000"
+                          << std::endl;
+            }
+            return;
+        }
 
-        // Setup the time manager
-        tm = manager;
-        assert(tm);
+        // ABDADA only applies when several threads search together
+        abdada = smpMode == SMP_ABDADA && threadCount > 1;
 
-        // Reset each thread
+        // Reset each thread and give it its own copy of the root moves
         for (auto& thread : threadData) {
-            thread.clear<false>();
+            thread->clear<false>();
+            thread->rootMoves = rootMoves;
         }
 
-        // Call this function with each non main thread now,
-        // this will skip this initialization
-        for (int i = 1; i < threadCount; ++i) {
-            threads.emplace_back(&Search::search, this, pos, manager, i);
-        }
+        // Wake each non main thread now, they will skip this initialization
+        wake(1, threadCount - 1);
     }
 
     Value score = -VALUE_INFINITE;
 
     // Create new position for each thread so there is no memory overlap
-    Position newPos = *pos;
-    SearchData* sd = &threadData[id];
+    Position newPos = *rootPos;
+    SearchData* sd = threadData[id].get();
+    newPos.set_evaluator(&sd->evaluator);
+    newPos.set_eval_cache(&sd->evalCache);
 
     Value average = -VALUE_INFINITE;
 
-    // Main iterative deepening loop
-    for (Depth depth = 1; depth <= maxDepth; ++depth) {
-        // Reset the pv table
-        sd->pvTable.reset();
+    // Track how many iterations in a row the best move stayed the same
+    Move previousBest = Move::none();
+    int bestMoveStability = 0;
+
+    // Main iterative deepening loop, helper threads may start deeper
+    for (Depth depth = 1 + (mainThread ? 0 : helperDepthOffset); depth <= maxDepth; ++depth) {
+        // Helper threads skip depths following their schedule so they spread
+        // over different depths instead of repeating the main thread, but
+        // with ABDADA all threads search the same depths
+        if (!mainThread && skipDepths && !abdada && skip_depth(id, depth)) continue;
+
         // Reset seldepth for this loop
-        sd->selDepth = 0;
-        // Set failedhigh counter to zero each iteration
-        int failedHigh = 0;
-
-        // Use aspiration windows to speed up searches based on recieved scores.
-        // We can use the (weighted) average score to determine values for alpha & beta
-        Value delta = 20 + average * average / 10000;
-        Value alpha = std::clamp(average - delta, -VALUE_INFINITE, +VALUE_INFINITE);
-        Value beta = std::clamp(average + delta, -VALUE_INFINITE, +VALUE_INFINITE);
-
-        // Iterative deepening until search times out or score falls within aspiration window.
-        while (tm->can_continue()) {
-            // Set a new depth for the search based on the number of previous
-            // searches that failed high.
-            Depth newDepth = std::max(1, depth - failedHigh);
-
-            sd->rootDelta = beta - alpha;
-            sd->rootDepth = newDepth;
-
-            // Find the bestmove and set the iterative average
-            if (!sd->bestMove.is_none() && score != VALUE_INFINITE) {
-                RootMove& rm = *std::find(rootMoves.begin(), rootMoves.end(), sd->bestMove);
-                average = rm.averageScore;
-            }
+        sd->selDepth.store(0, std::memory_order_relaxed);
+
+        // Search each pv line in turn, every pass excludes the root moves
+        // that already have a line at this depth
+        int lines = std::min(multiPV, static_cast<int>(sd->rootMoves.size()));
+
+        for (sd->pvIdx = 0; sd->pvIdx < lines; ++sd->pvIdx) {
+            // Reset the pv table
+            sd->pvTable.reset();
+            // Set failedhigh counter to zero each iteration
+            int failedHigh = 0;
+
+            // With several lines each one starts from its own previous score
+            if (multiPV > 1)
+                average = sd->rootMoves[sd->pvIdx].averageScore;
+            if (sd->pvIdx)
+                sd->bestMove = Move::none();
+
+            // Use aspiration windows to speed up searches based on recieved scores.
+            // We can use the (weighted) average score to determine values for alpha & beta
+            Value delta = 20 + average * average / 10000;
+            Value alpha = std::clamp(average - delta, -VALUE_INFINITE, +VALUE_INFINITE);
+            Value beta = std::clamp(average + delta, -VALUE_INFINITE, +VALUE_INFINITE);
+
+            // Iterative deepening until search times out or score falls within aspiration window.
+            while (tm->can_continue()) {
+                // Set a new depth for the search based on the number of previous
+                // searches that failed high.
+                Depth newDepth = std::max(1, depth - failedHigh);
+
+                sd->rootDelta = beta - alpha;
+                sd->rootDepth = newDepth;
+
+                // Find the bestmove and set the iterative average
+                if (!sd->bestMove.is_none() && score != VALUE_INFINITE) {
+                    RootMove& rm = *std::find(sd->rootMoves.begin(), sd->rootMoves.end(), sd->bestMove);
+                    average = rm.averageScore;
+                }
 
-            // Run the search
-            score = alphabeta<PV>(&newPos, sd, alpha, beta, newDepth);
+                // Run the search
+                score = alphabeta<PV>(&newPos, sd, alpha, beta, newDepth);
 
-            // Set previous scores
-            for (RootMove& rm : rootMoves) {
-                rm.previousScore = rm.currentScore;
-            }
+                // Set previous scores
+                for (RootMove& rm : sd->rootMoves) {
+                    rm.previousScore = rm.currentScore;
+                }
 
-            // Set this score in the search data
-            sd->score = score;
+                // Set this score in the search data
+                sd->score = score;
 
-            // Check for a stop
-            if (tm->forceStop) break;
-
-            // Check if we must research with a different window
-            if (score <= alpha) {
-                failedHigh = 0;
-                beta = (alpha + beta) / 2;
-                alpha = std::max(score - delta, -VALUE_INFINITE);
-                if (mainThread && infoStrings && tm->elapsed() >= 3000) 
-                    print_info_string<BOUND_UPPER>();
-            }
+                // Check for a stop
+                if (tm->stopped()) break;
 
-            else if (score >= beta) {
-                failedHigh++;
-                beta = std::min(score + delta, +VALUE_INFINITE);
-                if (mainThread && infoStrings && tm->elapsed() >= 3000) 
-                    print_info_string<BOUND_LOWER>();
+                // Check if we must research with a different window
+                if (score <= alpha) {
+                    failedHigh = 0;
+                    beta = (alpha + beta) / 2;
+                    alpha = std::max(score - delta, -VALUE_INFINITE);
+                    if (mainThread && infoStrings && tm->elapsed() >= 3000) 
+                        print_info_string<BOUND_UPPER>(sd);
+                }
+
+                else if (score >= beta) {
+                    failedHigh++;
+                    beta = std::min(score + delta, +VALUE_INFINITE);
+                    if (mainThread && infoStrings && tm->elapsed() >= 3000) 
+                        print_info_string<BOUND_LOWER>(sd);
+                }
+
+                else break;
+
+                delta += delta / 3;
             }
 
-            else break;
+            // Check for a stop
+            if (!tm->can_continue()) break;
+
+            // Store the line with its move and move it into its rank
+            auto rm = std::find(sd->rootMoves.begin() + sd->pvIdx, sd->rootMoves.end(), sd->bestMove);
+            assert(rm != sd->rootMoves.end());
+            rm->pv = sd->pvTable[0];
+            rm->pvScore = score;
+            std::rotate(sd->rootMoves.begin() + sd->pvIdx, rm, rm + 1);
+
+            // A later line may score better than the earlier ones, so keep the
+            // lines searched so far ordered by score
+            std::stable_sort(sd->rootMoves.begin(), sd->rootMoves.begin() + sd->pvIdx + 1,
+                             [](const RootMove& a, const RootMove& b) { return a.pvScore > b.pvScore; });
+        }
 
-            delta += delta / 3;
+        // The best move is always the first line, even if a later line was interrupted
+        if (sd->pvIdx) {
+            sd->bestMove = sd->rootMoves[0].m;
+            sd->score = score = sd->rootMoves[0].pvScore;
         }
 
         // Check for a stop
         if (!tm->can_continue()) break;
 
+        // Record the fully searched iteration
+        Value previousScore = sd->completedScore;
+        sd->completedDepth = sd->rootDepth;
+        sd->completedScore = score;
+        sd->completedMove = sd->rootMoves[0].m;
+        sd->completedPv = sd->rootMoves[0].pv;
+
         // If no stop can print out info strings for this depth
         if (mainThread && this->infoStrings)
-            print_info_string<BOUND_NONE>(); 
+            print_info_string<BOUND_NONE>(sd); 
+
+        // Update the best move stability
+        bestMoveStability = sd->bestMove == previousBest ? std::min(bestMoveStability + 1, 10) : 0;
+        previousBest = sd->bestMove;
+
+        // Decide if another iteration is worth starting. The optimal time is scaled
+        // up when the best move keeps changing, the score dropped or the best move
+        // took a small share of the nodes, and scaled down otherwise.
+        if (mainThread && tm->timeLimit.enabled && depth >= 4) {
+            // Share of root nodes spent on the best move
+            uint64_t totalNodes = 0, bestNodes = 0;
+            for (RootMove& rm : sd->rootMoves) {
+                totalNodes += rm.nodes;
+                if (rm.m == sd->bestMove) bestNodes = rm.nodes;
+            }
+            double nodeShare = totalNodes ? double(bestNodes) / totalNodes : 0.5;
+
+            double stabilityScale = 1.3 - 0.05 * bestMoveStability;
+            double scoreScale = std::clamp(1.0 + (previousScore - score) / 200.0, 0.9, 1.5);
+            double nodeScale = (1.5 - nodeShare) * 1.35;
+
+            if (tm->soft_limit_reached(stabilityScale * scoreScale * nodeScale)) break;
+        }
     }
 
-    // When the main thread is finished return the best move
-    // and close all other threads
+    // When the main thread is finished store the best move
+    // and wait for all other threads to finish
     if (mainThread) {
+        // The best move cannot be sent while pondering, so if the search
+        // finished early wait for either a ponderhit or a stop
+        while (tm->pondering() && !tm->stopped())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
         // Stop the search if any threads are still going
         tm->stop();
-        // Join all threads
-        for (auto& thread : threads) thread.join();
+        // Wait for the other threads to go back to idle
+        wait(1, threadCount - 1);
+
+        // Get the bestmove from the thread with the most votes, taking it from the
+        // same completed iteration as the score and pv, and show its line if it
+        // differs from what the main thread last printed. Only without any
+        // completed iteration is the move of the interrupted one used.
+        SearchData* best = best_thread();
+        resultMove = best->completedDepth ? best->completedMove : best->bestMove;
+
+        if (best != sd && infoStrings)
+            print_pv_line(BOUND_NONE, 1, best->completedDepth, best->completedScore, best->completedPv, best->completedMove);
+
+        // Report how often the eval caches of all threads saved an evaluation
+        if (infoStrings) {
+            uint64_t probes = 0, hits = 0;
+            for (auto& thread : threadData) {
+                probes += thread->evalCache.probes;
+                hits += thread->evalCache.hits;
+            }
 
-        // get the bestmove
-        Move best = sd->bestMove;
-        // Clear all thread data
-        threads.clear();
+            std::cout << "info string Eval cache hits "
+                      << (probes ? 100 * hits / probes : 0)
+                      << "% of "
+                      << probes
+                      << " probes"
+                      << std::endl;
+        }
 
-        // Return the best move
-        return best;
-    }
+        // Print the best move when the search was started in the background,
+        // along with the expected reply from the pv to ponder on
+        if (printBestMove) {
+            // Prefer the line ranked first when it starts with the move played. The
+            // current pv may be cut short by the stop or belong to another line, so
+            // after it fall back to the pv of the last completed iteration.
+            const PvLine& ranked = best->rootMoves[0].pv;
+            const PvLine& current = best->pvTable[0];
+            const PvLine& pv = ranked.size >= 2 && ranked.moves[0] == resultMove ? ranked
+                             : current.size >= 2 && current.moves[0] == resultMove ? current
+                             : best->completedPv;
+
+            std::cout << "bestmove " << from_move(resultMove, chess960);
+
+            if (pv.size >= 2 && pv.moves[0] == resultMove)
+                std::cout << " ponder " << from_move(pv.moves[1], chess960);
 
-    return Move::none();
+            std::cout << std::endl;
+        }
+    }
 }
 
 template<NodeType nodeType>
@@ -326,24 +762,22 @@ Value Search::alphabeta(Position* pos, SearchData* sd,
     assert(depth >= 0 && depth <= MAX_PLY);
 
     // Check for a force stop
-    if (tm->forceStop) {
+    if (tm->stopped()) {
         return beta;
     }
 
-    // Check if time is out every 1024 nodes, if true then fail high
-    if (sd->nodes % 1024 == 0
-        && sd->threadId == 0
-        && !tm->can_continue()) {
+    // Check if a search limit is reached, if true then fail high
+    if (limits_reached(sd)) {
         // Stop the search and fail high
         tm->stop();
         return beta;
     }
 
     // Increment nodes
-    sd->nodes++;
+    sd->add_node();
 
     // Update the seldepth
-    if (sd->ply + 1 > sd->selDepth) sd->selDepth = sd->ply + 1;
+    if (sd->ply + 1 > sd->sel_depth()) sd->selDepth.store(sd->ply + 1, std::memory_order_relaxed);
 
     // Get all search info needed
     bool  inCheck   = pos->checks();
@@ -353,6 +787,7 @@ Value Search::alphabeta(Position* pos, SearchData* sd,
     Value bestScore = -VALUE_INFINITE;
     Value score     = -VALUE_INFINITE;
     Value standpat  = VALUE_NONE;
+    Value rawEval   = VALUE_NONE;
     Value eval      = VALUE_NONE;
     Move  bestMove  = Move::none();
     Move  ttMove    = Move::none();
@@ -361,14 +796,14 @@ Value Search::alphabeta(Position* pos, SearchData* sd,
 
     // Check if a move draws from an upcoming repetition
     if (sd->ply && alpha < VALUE_DRAW && pos->has_game_cycled(sd->ply)) {
-        alpha = 8 - (sd->nodes & 0xF);
+        alpha = 8 - (sd->node_count() & 0xF);
         if (alpha >= beta) return alpha;
     }
 
     // Check for a draw
     if (sd->ply && pos->is_draw())
         // Draw randomization based on node count
-        return 8 - (sd->nodes & 0xF);
+        return 8 - (sd->node_count() & 0xF);
 
     // Check for max ply value and not in check, to return eval
     if (sd->ply >= MAX_PLY)
@@ -385,19 +820,19 @@ Value Search::alphabeta(Position* pos, SearchData* sd,
     hist->clear_killers_grandchildren(us, sd->ply);
 
     // Check for a transposition table entry
-    TTentry* entry = table.probe(key, found);
-    Value ttScore = found ? value_from_tt(entry->score(), sd->ply, pos->fifty_rule()) : VALUE_NONE;
+    TTentry entry = table.probe(key, found);
+    Value ttScore = found ? value_from_tt(entry.score(), sd->ply, pos->fifty_rule()) : VALUE_NONE;
 
     // Set the tt move
-    ttMove = found ? entry->move() : Move::none();
+    ttMove = found ? entry.move() : Move::none();
 
     // Check if tt can be used for an early cutoff
     if (found
         && !pvNode
         && sd->extMove.is_none()
-        && entry->depth() > depth - (entry->score() <= beta)
+        && entry.depth() > depth - (entry.score() <= beta)
         && ttScore != VALUE_NONE
-        && (entry->node() & (ttScore >= beta ? BOUND_LOWER : BOUND_UPPER))) {
+        && (entry.node() & (ttScore >= beta ? BOUND_LOWER : BOUND_UPPER))) {
 
         // If the ttMove is quiet, update move sorting heuristics
         if (!ttMove.is_none()) {
@@ -405,7 +840,7 @@ Value Search::alphabeta(Position* pos, SearchData* sd,
                 if (ttScore >= beta)
                     update_quiet_stats(pos, hist, sd->ply, ttMove, stat_bonus(depth));
                 else
-                    update_continuation_histories(pos, hist, sd->ply, pos->piece_moved(ttMove), 
+                    update_continuation_histories(hist, sd->ply, inCheck, pos->piece_moved(ttMove),
                                                   ttMove.to(), -stat_malus(depth));
             }
         }
@@ -416,23 +851,26 @@ Value Search::alphabeta(Position* pos, SearchData* sd,
 
     // Set standpat to a mate value for checks
     if (inCheck) {
-        standpat = eval = -VALUE_MATE + sd->ply;
+        rawEval = standpat = eval = -VALUE_MATE + sd->ply;
     }
     // For found transposition entries, try to find the standpat from there.
+    // The table holds the uncorrected eval, so the correction is always current.
     else if (found) {
-        standpat = eval = entry->eval();
+        rawEval = entry.eval();
         // For values of none, run an evaluate
-        if (standpat == VALUE_NONE || is_extremity(standpat))
-            standpat = eval = pos->evaluate();
+        if (rawEval == VALUE_NONE || is_extremity(rawEval))
+            rawEval = pos->evaluate();
+        standpat = eval = hist->correct_eval(pos, rawEval);
         // If the transposition table has a score we can use that for standpat
         if (ttScore != VALUE_NONE
-            && (entry->node() & (ttScore > eval ? BOUND_LOWER : BOUND_UPPER)))
+            && (entry.node() & (ttScore > eval ? BOUND_LOWER : BOUND_UPPER)))
             // Set the eval only, not standpat
             eval = ttScore;
     }
     // If no entry is found just evaluate normally
     else {
-        standpat = eval = pos->evaluate();
+        rawEval = pos->evaluate();
+        standpat = eval = hist->correct_eval(pos, rawEval);
     }
 
     // Set the historic eval with the standpat, rather than the
@@ -476,9 +914,12 @@ Value Search::alphabeta(Position* pos, SearchData* sd,
         Depth nmpReduction = std::min((eval - beta) / 200, 6) + depth / 3 + 5;
         Depth nmpDepth = std::max(0, depth - nmpReduction);
 
-        // Make the null move
+        // Make the null move, the replies have no move to continue from
+        hist->clear_continuation_move(sd->ply);
         pos->do_null();
+        sd->ply++;
         Value val = -alphabeta<NON_PV>(pos, sd, -beta, 1 - beta, nmpDepth);
+        sd->ply--;
         pos->undo_null();
 
         // Do not return unproven winning scores
@@ -501,6 +942,9 @@ Value Search::alphabeta(Position* pos, SearchData* sd,
     if (!inCheck && depth >= 4 && ttMove.is_none() && pvNode)
         depth -= 2;
 
+    // Keep the window's lower bound to know if the search raised alpha
+    Value oldAlpha = alpha;
+
     // Create move generator
     Generator gen(pos, hist, PV_SEARCH, ttMove, sd->ply);
     Move m;
@@ -521,9 +965,22 @@ Value Search::alphabeta(Position* pos, SearchData* sd,
         // If this is an extension move we should skip it
         if (sd->extMove == m) continue;
 
+        // At the root only search the moves of the current pv line
+        if (root && !sd->is_root_move(m)) continue;
+
         // Check the move here for legality
         if (!pos->is_legal(m)) continue;
 
+        // With ABDADA, after the first move at non-pv nodes, moves that another
+        // thread is searching are put off until all other moves are searched
+        bool abdadaNode = abdada && !pvNode && depth >= ABDADA_DEPTH && sd->extMove.is_none();
+        Key moveKey = abdadaNode ? move_key(key, m) : 0;
+
+        if (abdadaNode && legalMoves && !gen.is_deferring() && abdada_searching(moveKey)) {
+            gen.defer(m);
+            continue;
+        }
+
         // Get some information about the move
         Square from        = m.from();
         Square to          = m.to();
@@ -573,10 +1030,10 @@ Value Search::alphabeta(Position* pos, SearchData* sd,
             && sd->extMove.is_none()
             && m == ttMove
             && sd->ply > 0
-            && entry->depth() >= depth - 3
+            && entry.depth() >= depth - 3
             && ttScore != VALUE_NONE
             && !is_extremity(ttScore)
-            && (entry->node() & BOUND_LOWER)) {
+            && (entry.node() & BOUND_LOWER)) {
             // Compute values for singular beta and singular depth
             Value singularBeta = ttScore - depth * 2;
             Depth singularDepth = (depth - 1) / 2;
@@ -634,7 +1091,7 @@ Value Search::alphabeta(Position* pos, SearchData* sd,
         Depth reducedDepth = std::clamp(newDepth - reduction, 1, newDepth + 1);
 
         // Send information about the current move if enough time has passed
-        if (root && mainThread && infoStrings && !tm->forceStop && tm->elapsed() > 3000) {
+        if (root && mainThread && infoStrings && !tm->stopped() && tm->elapsed() > 3000) {
             std::cout << "info depth "
                       << sd->rootDepth
                       << " currmove "
@@ -644,7 +1101,14 @@ Value Search::alphabeta(Position* pos, SearchData* sd,
                       << std::endl;
         }
 
+        // Store the nodes before searching the move for root move node counts
+        uint64_t rootNodes = sd->node_count();
+
+        // Let other threads know this move is being searched
+        bool marked = abdadaNode && abdada_mark(moveKey);
+
         // Make the move
+        hist->set_continuation_move(sd->ply, pc, to);
         pos->do_move<true>(m);
 
         // Increment the ply counter
@@ -672,7 +1136,7 @@ Value Search::alphabeta(Position* pos, SearchData* sd,
                           : score >= beta ? stat_bonus(newDepth) : 0;
 
                 if (bonus)
-                    update_continuation_histories(pos, hist, sd->ply, pc, to, bonus);
+                    update_continuation_histories(hist, sd->ply - 1, inCheck, pc, to, bonus);
             }
         }
 
@@ -701,19 +1165,24 @@ Value Search::alphabeta(Position* pos, SearchData* sd,
         pos->undo_move(m);
         gen.add_searched(m);
 
+        if (marked) abdada_unmark(moveKey);
+
         // Decrement the ply counter
         sd->ply--;
 
         // Increment the legal moves
         legalMoves++;
 
-        // If the search stopped we cannot trust the return value
-        if (!tm->can_continue() || tm->forceStop) return beta;
+        // If the search stopped we cannot trust the return value. The clock
+        // is polled by the main thread in limits_reached, so here it is
+        // enough to check the stop flag.
+        if (tm->stopped()) return beta;
 
         // Update the rootmoves average score for aspiration windows
         if (root) {
             // Find the root move
-            RootMove& rm = *std::find(rootMoves.begin(), rootMoves.end(), m);
+            RootMove& rm = *std::find(sd->rootMoves.begin(), sd->rootMoves.end(), m);
+            rm.nodes += sd->node_count() - rootNodes;
             rm.averageScore = (rm.averageScore != -VALUE_INFINITE) 
                             ? (2 * score + rm.averageScore) / 3 : score;
             rm.currentScore = score;
@@ -729,17 +1198,22 @@ Value Search::alphabeta(Position* pos, SearchData* sd,
             if (root)
                 sd->bestMove = m;
 
-            // Update the pv at pv nodes
-            if (pvNode && mainThread)
+            // Update the pv at pv nodes, every thread keeps one
+            // since any of them may be chosen to report the result
+            if (pvNode)
                 sd->pvTable.update(m, sd->ply);
 
             // Check for a beta cutoff
             if (score >= beta) {
-                // Store the result in the transposition table
-                if (sd->extMove.is_none())
-                    table.save<nodeType>(key, depth, value_to_tt(score, sd->ply), standpat, m, BOUND_LOWER);
+                // Store the result in the transposition table, root scores of
+                // later pv lines exclude the best moves so are not stored
+                if (sd->extMove.is_none() && !(root && sd->pvIdx))
+                    table.save<nodeType>(key, depth, value_to_tt(score, sd->ply), rawEval, m, BOUND_LOWER);
                 // Update the histories
                 update_history(pos, hist, &gen, sd->ply, bestMove, depth);
+                // A quiet cutoff above the static eval corrects it upwards
+                if (!inCheck && sd->extMove.is_none() && !isCapture && !isPromotion && score > standpat)
+                    hist->update_correction(pos, score - standpat, depth);
                 // Return the score
                 return score;
             }
@@ -759,10 +1233,20 @@ Value Search::alphabeta(Position* pos, SearchData* sd,
     assert(bestScore > -VALUE_INFINITE && bestScore < VALUE_INFINITE);
 
     // Store the score into the transposition table
-    if (sd->extMove.is_none())
-        table.save<nodeType>(key, depth, value_to_tt(bestScore, sd->ply), standpat, bestMove,
+    if (sd->extMove.is_none() && !(root && sd->pvIdx))
+        table.save<nodeType>(key, depth, value_to_tt(bestScore, sd->ply), rawEval, bestMove,
                             (bestMove != Move::none() && pvNode) ? BOUND_EXACT : BOUND_UPPER);
 
+    // Update the eval correction from the search result, an upper bound can only
+    // correct the eval downwards and noisy best moves are not a fault of the eval.
+    // The score is only exact if it raised alpha, otherwise it is an upper bound.
+    bool exact = pvNode && bestScore > oldAlpha;
+    if (!inCheck
+        && sd->extMove.is_none()
+        && (bestMove.is_none() || (!pos->is_capture(bestMove) && !pos->is_promotion(bestMove)))
+        && (exact || bestScore < standpat))
+        hist->update_correction(pos, bestScore - standpat, depth);
+
     // Return the best score
     return bestScore;
 }
@@ -782,24 +1266,22 @@ Value Search::qsearch(Position* pos, SearchData* sd, Value alpha, Value beta) {
     Color us = pos->side();
 
     // Check for a force stop
-    if (tm->forceStop) {
+    if (tm->stopped()) {
         return beta;
     }
 
-    // Check if time is out every 1024 nodes, if true then fail high
-    if (sd->nodes % 1024 == 0
-        && sd->threadId == 0
-        && !tm->can_continue()) {
+    // Check if a search limit is reached, if true then fail high
+    if (limits_reached(sd)) {
         // Stop the search and fail high
         tm->stop();
         return beta;
     }
 
     // Increment the nodes
-    sd->nodes++;
+    sd->add_node();
 
     // Update seldepth
-    if (sd->ply + 1 > sd->selDepth) sd->selDepth = sd->ply + 1;
+    if (sd->ply + 1 > sd->sel_depth()) sd->selDepth.store(sd->ply + 1, std::memory_order_relaxed);
 
     // Get all search info needed
     bool  found     = false;
@@ -809,6 +1291,7 @@ Value Search::qsearch(Position* pos, SearchData* sd, Value alpha, Value beta) {
     Value bestScore = -VALUE_INFINITE;
     Value score     = -VALUE_INFINITE;
     Value standpat  = VALUE_NONE;
+    Value rawEval   = VALUE_NONE;
     Move  bestMove  = Move::none();
     Move  ttMove    = Move::none();
     History* hist   = &sd->hist;
@@ -816,22 +1299,22 @@ Value Search::qsearch(Position* pos, SearchData* sd, Value alpha, Value beta) {
     // Check for a draw
     if (sd->ply && pos->is_draw())
         // Draw randomization based on node count
-        return 8 - (sd->nodes & 0xF);
+        return 8 - (sd->node_count() & 0xF);
 
     // Check for max ply value and not in check, to return eval
     if (sd->ply >= MAX_PLY)
         return !inCheck ? pos->evaluate() : VALUE_DRAW;
 
     // Check for a transposition table entry
-    TTentry* entry = table.probe(key, found);
-    Value ttScore = found ? value_from_tt(entry->score(), sd->ply, pos->fifty_rule()) : VALUE_NONE;
+    TTentry entry = table.probe(key, found);
+    Value ttScore = found ? value_from_tt(entry.score(), sd->ply, pos->fifty_rule()) : VALUE_NONE;
 
     // Check if tt can be used for an early cutoff
     if (found
         && !pvNode
-        && entry->depth() >= inCheck
+        && entry.depth() >= inCheck
         && ttScore != VALUE_NONE
-        && (entry->node() & (ttScore >= beta ? BOUND_LOWER : BOUND_UPPER))) {
+        && (entry.node() & (ttScore >= beta ? BOUND_LOWER : BOUND_UPPER))) {
 
         // Return the score
         return ttScore;
@@ -839,25 +1322,27 @@ Value Search::qsearch(Position* pos, SearchData* sd, Value alpha, Value beta) {
 
     // Set standpat and bestscore to a mate value for checks
     if (inCheck) {
-        bestScore = standpat = -VALUE_INFINITE;
+        rawEval = bestScore = standpat = -VALUE_INFINITE;
     }
     else {
         // For found transposition entries, try to find the standpat from there.
         if (found) {
-            standpat = bestScore = entry->eval();
+            rawEval = entry.eval();
             // For values of none or extremeties, run an evaluate
-            if (standpat == VALUE_NONE || is_extremity(standpat))
-                bestScore = standpat = pos->evaluate();
+            if (rawEval == VALUE_NONE || is_extremity(rawEval))
+                rawEval = pos->evaluate();
+            standpat = bestScore = hist->correct_eval(pos, rawEval);
             // If the transposition table has a score we can use that for standpat
             if (ttScore != VALUE_NONE
                 && !is_extremity(ttScore)
-                && (entry->node() & (ttScore > bestScore ? BOUND_LOWER : BOUND_UPPER)))
+                && (entry.node() & (ttScore > bestScore ? BOUND_LOWER : BOUND_UPPER)))
                 // Set the eval only, not standpat
                 bestScore = ttScore;
         }
         // If no entry is found just evaluate normally
         else {
-            standpat = bestScore = pos->evaluate();
+            rawEval = pos->evaluate();
+            standpat = bestScore = hist->correct_eval(pos, rawEval);
         }
 
         // Check for an early cutoff
@@ -865,7 +1350,7 @@ Value Search::qsearch(Position* pos, SearchData* sd, Value alpha, Value beta) {
             // If not already in the hashtable, we can add it now
             if (!found)
                 table.save<NON_PV>(key, 0, value_to_tt(bestScore, sd->ply), 
-                                   standpat, Move::none(), BOUND_NONE);
+                                   rawEval, Move::none(), BOUND_NONE);
             // Return the score now
             return bestScore;
         }
@@ -937,6 +1422,7 @@ Value Search::qsearch(Position* pos, SearchData* sd, Value alpha, Value beta) {
         moveCnt++;
 
         // Make the move
+        hist->set_continuation_move(sd->ply, pc, to);
         pos->do_move<true>(m);
         // Increment the ply
         sd->ply++;
@@ -981,22 +1467,20 @@ Value Search::qsearch(Position* pos, SearchData* sd, Value alpha, Value beta) {
     // If there is moves, store the best value in the transposition table.
     // The depth is determined by if there is a beta cutoff and in check.
     if (!bestMove.is_none())
-        table.save<nodeType>(key, ttDepth, value_to_tt(bestScore, sd->ply), standpat, bestMove,
+        table.save<nodeType>(key, ttDepth, value_to_tt(bestScore, sd->ply), rawEval, bestMove,
                              bestScore >= beta ? BOUND_LOWER : BOUND_UPPER);
 
     // Return the best score
     return bestScore;
 }
 
-void update_continuation_histories(Position* pos, History* hist, 
-                                   int ply, Piece pc, Square to, int bonus) {
-    for (int i : {1, 2, 3, 4, 6}) {
+void update_continuation_histories(History* hist, int ply, bool inCheck,
+                                   Piece pc, Square to, int bonus) {
+    for (int i : {1, 2, 4}) {
         // Only update first two if in check
-        if (pos->checks() && i > 2) 
+        if (inCheck && i > 2) 
             break;
-        if (pos->previous_ok(i)) {
-            hist->update_continuation(pc, to, ply - i, bonus);
-        }
+        hist->update_continuation(pc, to, ply - i, bonus);
     }
 }
 
@@ -1009,7 +1493,7 @@ void update_quiet_stats(Position* pos, History* hist, int ply, Move m, int bonus
 
     // Update main and continuation history
     hist->update_butterfly(us, m, bonus);
-    update_continuation_histories(pos, hist, ply, pos->piece_moved(m), m.to(), bonus);
+    update_continuation_histories(hist, ply, pos->checks(), pos->piece_moved(m), m.to(), bonus);
 }
 
 void update_history(Position* pos, History* hist, Generator* gen, 
@@ -10,30 +10,50 @@
 #include "pv.hpp"
 #include "history.hpp"
 
+#include <algorithm>
+#include <functional>
 #include <thread>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
 
 namespace Stella {
 
+// Parallel search modes
+enum SMPMode {
+    SMP_LAZY,
+    SMP_ABDADA
+};
+
 // Structure for storing a "Root Move" which is a move that exists in the root position
 struct RootMove {
     // Store the move
     Move m;
 
     // Create an operator to check if one Root Move is equal to another
-    bool operator==(const Move& move) { return move == m; }
+    bool operator==(const Move& move) const { return move == m; }
 
     // Store average, current and previous score found through search
     Value averageScore =  -VALUE_INFINITE;
     Value previousScore = -VALUE_INFINITE;
     Value currentScore =  -VALUE_INFINITE;
 
+    // Store the nodes spent searching this move
+    uint64_t nodes = 0;
+
+    // Store the line and score found when this move was searched as a pv line
+    PvLine pv;
+    Value pvScore = -VALUE_INFINITE;
+
     // Constructor for a Root Move
     RootMove(Move move) { m = move; }
 };
 
 // Structure for storing information to be continuously updated and used through recursive search.
 // Inherits move histories which are updated ply by ply in a new instance.
-struct SearchData {
+// Aligned to a cache line so no two threads ever share one.
+struct alignas(64) SearchData {
     // Thread data
     int threadId;
     int ply;
@@ -41,13 +61,28 @@ struct SearchData {
     bool stop;
     Pv pvTable;
     History hist;
+    Network::Evaluator evaluator;
+    EvalCache evalCache;
+
+    // Counters read by other threads while this one searches, kept on their own
+    // cache line. Only the owning thread writes them, using relaxed operations.
+    alignas(64) std::atomic<uint64_t> nodes;
+    std::atomic<Depth> selDepth;
 
     // Search data
-    uint64_t nodes;
-    Depth selDepth;
-    Value score;
+    alignas(64) Value score;
     Move bestMove;
 
+    // Root moves are kept per thread so threads never write to shared scores.
+    // Moves before pvIdx already have a line this iteration and are skipped.
+    std::vector<RootMove> rootMoves;
+    int pvIdx;
+    // Depth, score, move and pv of the last fully completed iteration, used to pick a best thread
+    Depth completedDepth;
+    Value completedScore;
+    Move completedMove;
+    PvLine completedPv;
+
     // Heuristics
     Depth nmpMinPly;
     Value rootDelta;
@@ -59,6 +94,16 @@ struct SearchData {
     // Function to clear searchdata
     template<bool full>
     void clear();
+
+    // Relaxed accessors for the shared counters
+    uint64_t node_count() const { return nodes.load(std::memory_order_relaxed); }
+    void add_node() { nodes.store(node_count() + 1, std::memory_order_relaxed); }
+    Depth sel_depth() const { return selDepth.load(std::memory_order_relaxed); }
+
+    // Check if a move is searched in the current pv line
+    bool is_root_move(Move m) const {
+        return std::find(rootMoves.begin() + pvIdx, rootMoves.end(), m) != rootMoves.end();
+    }
 };
 
 // Class the manage the search, allocation of threads and time management
@@ -68,23 +113,68 @@ private:
     int threadCount = 1;
     // Store each thread and it's relevent data
     std::vector<std::thread> threads;
-    std::vector<SearchData> threadData;
-
-    // Store the rootmoves of the position
-    std::vector<RootMove> rootMoves;
+    std::vector<std::unique_ptr<SearchData>> threadData;
+
+    // Cpus to pin threads to, thread i uses cpu i modulo the list size
+    std::vector<int> affinity;
+    // Cpus of each NUMA node when weights are replicated per node
+    std::vector<std::vector<int>> numaNodes;
+
+    // Threads are kept alive between searches and parked on a condition variable,
+    // each thread waits for its flag to be set before it starts searching
+    std::mutex poolMutex;
+    std::condition_variable poolCv;
+    std::vector<bool> searching;
+    bool exitPool = false;
+    // Task run by woken threads in place of a search, given the thread id and count
+    const std::function<void(int, int)>* poolTask = nullptr;
+
+    // Position to search from and the resulting best move
+    Position* rootPos = nullptr;
+    Move resultMove = Move::none();
+    // Flag for printing the best move once a search finishes
+    bool printBestMove = false;
 
     // Depths for lmr
     Depth lmr[MAX_PLY][MAX_MOVES];
 
     // Flag for enabling/disabling info strings
     bool infoStrings = true;
+    // Number of pv lines to search and report
+    int multiPV = 1;
+    // Parallel search mode, ABDADA is only used with more than one thread
+    SMPMode smpMode = SMP_LAZY;
+    bool abdada = false;
+    // Flag for helper threads skipping depths, and the depth they start at
+    bool skipDepths = true;
+    int helperDepthOffset = 0;
     // Flag for chess960
     bool chess960 = false;
 
     // Time manager
     TimeManager* tm;
 
+    // Loop run by each thread in the pool, waits until woken to search
+    void idle_loop(int id);
+    // Wake the given threads and wait for them to finish searching
+    void wake(int first, int last);
+    void wait(int first, int last);
+    // Launch or join all threads in the pool
+    void launch_pool();
+    void close_pool();
+
+    // Iterative deepening function run by each thread
+    void iterative_deepening(int id);
+
+    // Check if a helper thread skips a depth in its schedule
+    bool skip_depth(int id, Depth depth) const;
+
+    // Periodically check if the time or node limits have been reached
+    bool limits_reached(SearchData* sd);
+
 public:
+    // Destructor closes the thread pool
+    ~Search();
     // Initialize lmr array
     void init_lmr();
     // Get the reduction for this depth
@@ -93,16 +183,37 @@ public:
     void set_info_string(bool val) { infoStrings = val; }
     // Function for printing info string to the shell
     template<Bound bound>
-    void print_info_string();
-    // Set the number of threads
+    void print_info_string(const SearchData* sd);
+    // Function for printing a single pv line
+    void print_pv_line(Bound bound, int line, Depth depth, Value score, const PvLine& pv, Move best);
+    // Set the number of pv lines
+    void set_multipv(int lines) { multiPV = std::max(1, lines); }
+    // Set the parallel search mode
+    void set_smp_mode(SMPMode mode) { smpMode = mode; }
+    // Set the depth schedule of helper threads
+    void set_skip_depths(bool val) { skipDepths = val; }
+    void set_helper_depth_offset(int offset) { helperDepthOffset = std::clamp(offset, 0, 1); }
+    // Choose the thread whose result to play by voting across all threads
+    SearchData* best_thread();
+    // Set the number of threads, limited to the cpus available
     void set_threads(int num);
-    // Stop threads
-    void stop();
+    // Run a task on every thread of the pool at once, each on its own cpu
+    void run_on_threads(const std::function<void(int, int)>& task);
+    int thread_count() const { return threadCount; }
+    // Set the cpus threads are pinned to
+    bool set_affinity(const std::string& policy);
+    const std::vector<int>& affinity_cpus() const { return affinity; }
+    // Set NUMA replication of the network weights
+    int set_numa(bool enabled);
     // Clear all the thread data
     void clear_thread_data();
 
-    // Main search function to launch threads
-    Move search(Position* pos, TimeManager* manager, int id = 0);
+    // Start a search in the background, the best move is printed when it finishes
+    void start(Position* pos, TimeManager* manager);
+    // Wait for a search started in the background to finish
+    void wait_for_search();
+    // Run a search and return the best move once it finishes
+    Move search(Position* pos, TimeManager* manager);
 
     // Alpha beta pruning function, takes into account many heuristics to return an evaluation
     template<NodeType nodeType>
@@ -16,11 +16,13 @@ void TimeManager::set_move_overhead(int time) {
 
 void TimeManager::reset() {
     timer.start();
-    forceStop = false;
+    forceStop.store(false, std::memory_order_relaxed);
+    ponder.store(false, std::memory_order_relaxed);
     depthLimit = {};
     nodeLimit = {};
     moveTimeLimit = {};
     timeLimit = {};
+    searchMoves.clear();
 }
 
 uint64_t TimeManager::elapsed() {
@@ -48,7 +50,9 @@ void TimeManager::set_move_time_limit(uint64_t time) {
 
 bool TimeManager::can_continue() {
     // Check if force stop
-    if (forceStop) return false;
+    if (stopped()) return false;
+    // Time limits do not apply while pondering
+    if (pondering()) return true;
     // Get the elapsed time
     uint64_t time = elapsed();
     // Check if the time exceeds the limit
@@ -59,6 +63,12 @@ bool TimeManager::can_continue() {
     return true;
 }
 
+bool TimeManager::soft_limit_reached(double scale) {
+    return timeLimit.enabled
+        && !pondering()
+        && elapsed() >= std::min(static_cast<double>(timeLimit.max), timeLimit.optimal * scale);
+}
+
 // Given the total time, increment and expected number of moves left,
 // calculates a maximum time to spend on the current move. This is
 // further shortened using heuristics from the search to determine
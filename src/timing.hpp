@@ -4,6 +4,9 @@
 #include "types.hpp"
 #include "misc.hpp"
 
+#include <atomic>
+#include <vector>
+
 namespace Stella {
 
 struct Limits {
@@ -28,11 +31,18 @@ public:
     Limits moveTimeLimit;
     TimeLimits timeLimit;
 
+    // Restrict the search to these root moves if any are given
+    std::vector<Move> searchMoves;
+
     // Store move overhead in milliseconds
     int moveOverhead;
 
-    // Flag for force stopping search
-    bool forceStop;
+    // Flag for force stopping search, set by the uci thread and polled by
+    // every search thread so it is read and written with relaxed atomics
+    std::atomic<bool> forceStop;
+
+    // Flag for pondering, time limits are ignored until a ponderhit
+    std::atomic<bool> ponder;
 
     // Start time of search
     Timer timer;
@@ -53,10 +63,23 @@ public:
     void set_move_overhead(int time);
 
     // Stop the search
-    void stop() { forceStop = true; };
+    void stop() { forceStop.store(true, std::memory_order_relaxed); };
+    // Check if the search was force stopped
+    bool stopped() const { return forceStop.load(std::memory_order_relaxed); }
+
+    // Switch a ponder search to a normal timed search. Time is still counted
+    // from the start of the search, so time spent pondering is treated as
+    // already used and an expected move is played quickly.
+    void ponderhit() { ponder.store(false, std::memory_order_relaxed); }
+    // Check if the search is pondering
+    bool pondering() const { return ponder.load(std::memory_order_relaxed); }
 
     // Check if search can continue an iterative deepening loop
     bool can_continue();
+
+    // Check if the optimal time, scaled by the given factor, has been used up.
+    // Only checked between iterations, the maximum time stays a hard limit.
+    bool soft_limit_reached(double scale);
 };
 
 }
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "topology.hpp"
+
+namespace Stella::Topology {
+
+// Read a single integer from a file, returning the fallback if it cannot be read
+static int read_int(const std::string& path, int fallback) {
+    std::ifstream file(path);
+    int value;
+    return (file >> value) ? value : fallback;
+}
+
+std::vector<Cpu> cpus() {
+    std::vector<Cpu> result;
+
+    #if defined(__linux__)
+    // Only consider the cpus the process is allowed to run on
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed)) return result;
+
+    for (int id = 0; id < CPU_SETSIZE; ++id) {
+        if (!CPU_ISSET(id, &allowed)) continue;
+
+        std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/topology/";
+
+        // Without topology information every cpu is treated as its own core
+        int core = read_int(base + "core_id", id);
+        int package = read_int(base + "physical_package_id", 0);
+
+        // Count the lower numbered cpus sharing this core
+        int sibling = std::count_if(result.begin(), result.end(), [&](const Cpu& c) {
+            return c.core == core && c.package == package;
+        });
+
+        result.push_back({ id, core, package, sibling });
+    }
+    #endif
+
+    return result;
+}
+
+std::vector<int> parse_list(const std::string& list) {
+    std::vector<int> result;
+    std::stringstream ss(list);
+    std::string range;
+
+    // Each comma separated entry is a cpu or an inclusive range of cpus
+    while (std::getline(ss, range, ',')) {
+        int first, last;
+        char dash;
+        std::stringstream rs(range);
+
+        if (!(rs >> first)) return {};
+
+        if (rs >> dash) {
+            if (dash != '-' || !(rs >> last) || last < first) return {};
+        }
+        else last = first;
+
+        if (first < 0) return {};
+
+        for (int cpu = first; cpu <= last; ++cpu)
+            result.push_back(cpu);
+    }
+
+    return result;
+}
+
+std::vector<int> placement(const std::string& policy) {
+    std::vector<Cpu> list = cpus();
+
+    // Keep the cpus of an explicit list that the process may run on
+    if (policy != "compact" && policy != "scatter") {
+        std::vector<int> result = parse_list(policy);
+
+        if (!list.empty())
+            result.erase(std::remove_if(result.begin(), result.end(), [&](int cpu) {
+                return std::none_of(list.begin(), list.end(), [&](const Cpu& c) { return c.id == cpu; });
+            }), result.end());
+
+        return result;
+    }
+
+    // Number the cores within each package so scatter can interleave packages
+    std::map<std::pair<int, int>, int> coreIndex;
+    std::map<int, int> coresInPackage;
+    for (const Cpu& c : list)
+        if (!coreIndex.count({ c.package, c.core }))
+            coreIndex[{ c.package, c.core }] = coresInPackage[c.package]++;
+
+    auto key = [&](const Cpu& c) {
+        int core = coreIndex[{ c.package, c.core }];
+        return policy == "compact" ? std::make_tuple(c.sibling, c.package, core, c.id)
+                                   : std::make_tuple(c.sibling, core, c.package, c.id);
+    };
+
+    std::sort(list.begin(), list.end(), [&](const Cpu& a, const Cpu& b) { return key(a) < key(b); });
+
+    std::vector<int> result;
+    for (const Cpu& c : list)
+        result.push_back(c.id);
+
+    return result;
+}
+
+std::vector<std::vector<int>> nodes() {
+    std::vector<std::vector<int>> result;
+    std::vector<Cpu> allowed = cpus();
+
+    // Node numbers may have gaps, so take them from the list of online nodes
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string onlineList;
+    if (!std::getline(online, onlineList)) return result;
+
+    for (int node : parse_list(onlineList)) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+
+        if (!std::getline(file, list)) continue;
+
+        std::vector<int> nodeCpus;
+        for (int cpu : parse_list(list))
+            if (std::any_of(allowed.begin(), allowed.end(), [&](const Cpu& c) { return c.id == cpu; }))
+                nodeCpus.push_back(cpu);
+
+        if (!nodeCpus.empty())
+            result.push_back(nodeCpus);
+    }
+
+    return result;
+}
+
+int node_of(int cpu, const std::vector<std::vector<int>>& nodes) {
+    for (size_t i = 0; i < nodes.size(); ++i)
+        if (std::find(nodes[i].begin(), nodes[i].end(), cpu) != nodes[i].end())
+            return i;
+
+    return -1;
+}
+
+bool pin_thread(int cpu) {
+    return pin_thread(std::vector<int>{ cpu });
+}
+
+bool pin_thread(const std::vector<int>& cpus) {
+    #if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    for (int cpu : cpus) {
+        if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+        CPU_SET(cpu, &set);
+    }
+
+    return !pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    #else
+    (void)cpus;
+    return false;
+    #endif
+}
+
+}
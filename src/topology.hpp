@@ -0,0 +1,44 @@
+#ifndef TOPOLOGY_H_INCLUDED
+#define TOPOLOGY_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+namespace Stella::Topology {
+
+// Logical cpu and where it sits in the machine
+struct Cpu {
+    int id;
+    int core;
+    int package;
+    // Index of this cpu among the logical cpus sharing its core
+    int sibling;
+};
+
+// Read the logical cpus this process may run on from /sys, empty if unknown
+std::vector<Cpu> cpus();
+
+// Parse a cpu list in the kernel format, for example "0-3,8,10-11".
+// Returns an empty list if the string is not a valid cpu list.
+std::vector<int> parse_list(const std::string& list);
+
+// Order the cpus to place threads on for a given policy. Compact fills the
+// cores of one package before the next, scatter alternates between packages.
+// Both use every physical core before any hyperthread sibling. Any other
+// policy is read as an explicit cpu list, dropping cpus that are not available.
+std::vector<int> placement(const std::string& policy);
+
+// Read the cpus of each NUMA node from /sys/devices/system/node, limited to
+// the cpus this process may run on. Nodes without such cpus are left out.
+std::vector<std::vector<int>> nodes();
+
+// Find the node of a cpu in a list of nodes, returns -1 if not found
+int node_of(int cpu, const std::vector<std::vector<int>>& nodes);
+
+// Pin the calling thread to a single cpu or a set of cpus, returns false if it failed
+bool pin_thread(int cpu);
+bool pin_thread(const std::vector<int>& cpus);
+
+}
+
+#endif
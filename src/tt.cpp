@@ -1,4 +1,15 @@
+#include <atomic>
 #include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "tt.hpp"
 #include "types.hpp"
@@ -7,62 +18,241 @@ namespace Stella {
 
 TTtable table;
 
+// Unsigned 128 bit integer used for indexing the table
+__extension__ using uint128 = unsigned __int128;
+
+// Header written at the start of a hash file. The header is padded to a full
+// page so the buckets following it stay aligned when the file is mapped.
+struct TTfileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entrySize;
+    uint32_t bucketSize;
+    uint32_t generation;
+    uint64_t buckets;
+};
+
+// Header at the start of a shared memory segment, padded to a full page like the
+// hash file. It holds the generation shared by all the attached processes.
+struct TTsharedHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entrySize;
+    uint32_t bucketSize;
+    uint32_t generation;
+    uint64_t buckets;
+};
+
+#if defined(__linux__)
+// Processes sharing a segment coordinate through locks on two bytes of it. The
+// first is held exclusively while attaching or detaching. The second is held
+// shared by every process for as long as it is attached, and as the kernel drops
+// the locks of a process that exits or crashes, only the last process attached
+// can take it exclusively.
+constexpr off_t SHARED_SERIAL_BYTE = 0;
+constexpr off_t SHARED_ALIVE_BYTE = 1;
+
+// Lock a byte of a segment for the open descriptor, returns false if it is held
+// by another process and not waiting. Changing the type of a held lock is atomic.
+static bool lock_shared_byte(int fd, off_t byte, short type, bool wait) {
+    struct flock lock = {};
+    lock.l_type = type;
+    lock.l_whence = SEEK_SET;
+    lock.l_start = byte;
+    lock.l_len = 1;
+    return !fcntl(fd, wait ? F_OFD_SETLKW : F_OFD_SETLK, &lock);
+}
+
+// Check the name of a segment still refers to an open descriptor, it may
+// have been removed by the last process detaching before the lock was taken
+static bool is_linked(int fd, const std::string& name) {
+    int current = shm_open(name.c_str(), O_RDWR, 0600);
+    if (current < 0) return false;
+
+    struct stat opened, named;
+    bool same = !fstat(fd, &opened) && !fstat(current, &named)
+             && opened.st_dev == named.st_dev && opened.st_ino == named.st_ino;
+    close(current);
+    return same;
+}
+#endif
+
+constexpr char TT_FILE_MAGIC[8] = { 'S', 'T', 'E', 'L', 'L', 'A', 'T', 'T' };
+constexpr uint32_t TT_FILE_VERSION = 1;
+constexpr size_t TT_FILE_HEADER_SIZE = 4096;
+
 void TTentry::clear() {
-    key32 = 0;
-    score16 = 0;
-    eval16 = 0;
-    move16 = Move::none();
-    depth8 = 0;
-    node8 = 0;
-    age8 = 0;
+    key64 = 0;
+    data64 = 0;
 }
 
 TTtable::~TTtable() {
     dealloc();
 }
 
+// Returns the number of generations since an entry was last written
+inline uint8_t relative_age(uint8_t generation, uint8_t age) {
+    return (generation - age) & 0x1F;
+}
+
+// Read both words of an entry in the table into a local copy. The words are
+// read individually so a concurrent write can tear them, which is caught by
+// the key check since the key word is stored xor'd with the data word.
+TTentry TTtable::load(const TTentry* entry) {
+    TTentry copy;
+    copy.key64 = __atomic_load_n(&entry->key64, __ATOMIC_RELAXED);
+    copy.data64 = __atomic_load_n(&entry->data64, __ATOMIC_RELAXED);
+    return copy;
+}
+
+TTbucket* TTtable::bucket(Key key) const {
+    // Map the key onto the range of buckets using the upper half of a 128 bit
+    // multiply, this works for any table size rather than only powers of 2
+    return &buckets[(static_cast<uint128>(key) * num) >> 64];
+}
+
 template<NodeType T>
 void TTtable::save(Key key, Depth depth, Value score, Value eval, Move m, Bound b) {
-    // Get the entry for the given key
-    TTentry* entry = &entries[(num - 1) & key];
+    // Get the bucket for the given key
+    TTbucket* bkt = bucket(key);
 
     // Make sure depth is within bounds
     assert(depth >= 0 && depth <= MAX_PLY);
     // Make sure scores are within bounds
     assert(score > -VALUE_INFINITE && score < VALUE_INFINITE);
-    // Ensure entry is not null
-    assert(entry);
+    // Ensure bucket is not null
+    assert(bkt);
+
+    // Look for an entry already holding this key, otherwise select the entry
+    // least worth keeping, which is the shallowest and oldest in the bucket
+    int replace = 0;
+    bool found = false;
+    TTentry entry = load(&bkt->entries[0]);
+
+    for (int i = 0; i < TT_BUCKET_SIZE; ++i) {
+        TTentry candidate = i ? load(&bkt->entries[i]) : entry;
+        if (candidate.key() == key) {
+            replace = i;
+            entry = candidate;
+            found = true;
+            break;
+        }
+        if (candidate.depth() - 8 * relative_age(generation, candidate.age())
+            < entry.depth() - 8 * relative_age(generation, entry.age())) {
+            replace = i;
+            entry = candidate;
+        }
+    }
 
-    // Keep the existing move if none is given
-    if (m.is_none()) m = entry->move16;
+    // Keep the existing move if none is given for the same position
+    if (found && m.is_none()) m = entry.move();
 
     // Check for a possible replacement
     // Go from least expensive to most when checking for replacement conditions
-    if (b == BOUND_EXACT
-        || entry->key32 != static_cast<uint32_t>(key)
-        || entry->age8 != generation
-        || entry->depth8 <= depth) {
+    if (!found
+        || b == BOUND_EXACT
+        || entry.age() != generation
+        || entry.depth() <= depth) {
+
+        // Pack the data word
+        uint64_t data = static_cast<uint64_t>(static_cast<uint16_t>(score))
+                      | static_cast<uint64_t>(static_cast<uint16_t>(eval)) << 16
+                      | static_cast<uint64_t>(m.data()) << 32
+                      | static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 48
+                      | static_cast<uint64_t>(generation << 3 | static_cast<bool>(T) << 2 | b) << 56;
 
         // Fill the entry
-        entry->key32 = static_cast<uint32_t>(key);
-        entry->score16 = static_cast<int16_t>(score);
-        entry->eval16 = static_cast<int16_t>(eval);
-        entry->move16 = static_cast<Move>(m);
-        entry->depth8 = static_cast<uint8_t>(depth);
-        entry->node8 = static_cast<uint8_t>(static_cast<bool>(T) << 2 | b);
-        entry->age8 = static_cast<uint8_t>(generation);
+        TTentry* target = &bkt->entries[replace];
+        __atomic_store_n(&target->data64, data, __ATOMIC_RELAXED);
+        __atomic_store_n(&target->key64, key ^ data, __ATOMIC_RELAXED);
     }
 }
 
 template void TTtable::save<PV>(Key key, Depth depth, Value score, Value eval, Move m, Bound b);
 template void TTtable::save<NON_PV>(Key key, Depth depth, Value score, Value eval, Move m, Bound b);
 
-TTentry* TTtable::probe(Key key, bool& found) const {
-    // Get the entry for this key
-    TTentry* entry = &entries[(num - 1) & key];
-    // Check if entry exists or matches the given key
-    if (entry->key32 == 0 || entry->key32 != static_cast<uint32_t>(key)) return found = false, entry;
-    else return found = true, entry;
+TTentry TTtable::probe(Key key, bool& found) const {
+    // Get the bucket for this key
+    const TTbucket* bkt = bucket(key);
+
+    // Check each entry in the bucket for a match of the given key
+    for (int i = 0; i < TT_BUCKET_SIZE; ++i) {
+        TTentry entry = load(&bkt->entries[i]);
+        if (entry.key() == key)
+            return found = true, entry;
+    }
+
+    // Return an empty entry if not found
+    TTentry entry;
+    entry.clear();
+    return found = false, entry;
+}
+
+// Values saved with a key in the stress test, each derived from the key so a probe
+// can tell whether the data it was given belongs to the key it asked for. The test
+// keys are small, so they are mixed first to make every field vary between keys.
+static uint64_t stress_mix(Key key) { return key * 0x9E3779B97F4A7C15ULL; }
+static Value stress_score(Key key) { return Value((stress_mix(key) >> 8) % 20000) - 10000; }
+static Value stress_eval(Key key) { return Value((stress_mix(key) >> 24) % 20000) - 10000; }
+static Move stress_move(Key key) { return Move(static_cast<int16_t>(stress_mix(key) >> 40 | 1)); }
+static Depth stress_depth(Key key) { return Depth((stress_mix(key) >> 56) % (MAX_PLY + 1)); }
+
+void TTtable::stress_test(int threads, uint64_t iterations, uint64_t& hits, uint64_t& mismatches) {
+    // Keys below this limit all map to the first bucket, use a handful of them so
+    // that every save replaces an entry another thread may be reading
+    const uint64_t span = UINT64_MAX / num;
+    constexpr int NB_KEYS = 16;
+    Key keys[NB_KEYS];
+    for (int i = 0; i < NB_KEYS; ++i) {
+        keys[i] = 1 + (0x9E3779B97F4A7C15ULL * (i + 1)) % (span - 1);
+        assert(bucket(keys[i]) == buckets);
+    }
+
+    std::atomic<uint64_t> totalHits{0};
+    std::atomic<uint64_t> totalMismatches{0};
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            uint64_t threadHits = 0, threadMismatches = 0;
+            uint64_t seed = 0x2545F4914F6CDD1DULL * (t + 1);
+
+            for (uint64_t i = 0; i < iterations; ++i) {
+                seed ^= seed >> 12, seed ^= seed << 25, seed ^= seed >> 27;
+                Key key = keys[(seed * 2685821657736338717ULL) >> 60];
+
+                // Alternate between overwriting the key and reading it back
+                if (i & 1) {
+                    save<PV>(key, stress_depth(key), stress_score(key), stress_eval(key),
+                             stress_move(key), BOUND_EXACT);
+                    continue;
+                }
+
+                bool found;
+                TTentry entry = probe(key, found);
+                if (!found) continue;
+
+                ++threadHits;
+                if (entry.score() != stress_score(key)
+                    || entry.eval() != stress_eval(key)
+                    || entry.move() != stress_move(key)
+                    || entry.depth() != stress_depth(key))
+                    ++threadMismatches;
+            }
+
+            totalHits += threadHits;
+            totalMismatches += threadMismatches;
+        });
+    }
+
+    for (std::thread& worker : workers) worker.join();
+
+    hits = totalHits;
+    mismatches = totalMismatches;
+
+    // Wipe the entries written by the test
+    dirty = true;
+    clear();
 }
 
 void TTtable::resize(size_t mb) {
@@ -76,61 +266,330 @@ void TTtable::resize(size_t mb) {
     constexpr size_t alignment = 2 * 1024 * 1024;
     size = ((bytes + alignment - 1) / alignment) * alignment;
 
-    // Allocate the memory to the entires
-    entries = static_cast<TTentry*>(aligned_malloc(alignment, size));
+    // Attach to a shared segment if one is requested, the size of an existing segment
+    // takes priority over the size requested. Fall back to a private table on failure.
+    if (!sharedName.empty() && attach_shared(size)) {
+        num = size / sizeof(TTbucket);
+        dirty = true;
+        clear();
+        return;
+    }
+
+    // Random probes into a large table are dominated by TLB misses, so try to
+    // back it with huge pages. First ask the kernel for explicit huge pages,
+    // which only succeeds if they have been reserved on the system.
+    #if defined(__linux__)
+    void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    if (mem != MAP_FAILED) {
+        buckets = static_cast<TTbucket*>(mem);
+        backing = BACKING_HUGE;
+    }
+    // Otherwise fall back onto an aligned allocation, and advise the kernel to use
+    // transparent huge pages for it. The alignment ensures whole pages are used.
+    else {
+        buckets = static_cast<TTbucket*>(aligned_malloc(alignment, size));
+        backing = madvise(buckets, size, MADV_HUGEPAGE) ? BACKING_NORMAL : BACKING_TRANSPARENT;
+    }
+    #else
+    // Allocate the memory to the buckets
+    buckets = static_cast<TTbucket*>(aligned_malloc(alignment, size));
+    backing = BACKING_NORMAL;
+    #endif
 
     // Set internal variables to reflect current size of table
-    num = size / sizeof(TTentry);
+    num = size / sizeof(TTbucket);
+
+    // The memory has not been touched yet so it must be cleared
+    dirty = true;
 
     // Clear the table after allocating it
     clear();
 }
 
 void TTtable::clear() {
+    // A shared table still in use by other processes must not be cleared,
+    // just follow the generation they are using
+    if (backing == BACKING_SHARED) {
+        #if defined(__linux__)
+        TTsharedHeader* header = reinterpret_cast<TTsharedHeader*>(
+            reinterpret_cast<char*>(buckets) - TT_FILE_HEADER_SIZE);
+        generation = __atomic_load_n(&header->generation, __ATOMIC_RELAXED) & 0x1F;
+        if (!lock_shared_byte(sharedFd, SHARED_ALIVE_BYTE, F_WRLCK, false)) return;
+        lock_shared_byte(sharedFd, SHARED_ALIVE_BYTE, F_RDLCK, false);
+        #endif
+    }
+
     // Reset generation
     generation = 0;
-    // Check for entries, if they exist clear them
-    if (entries) {
-        for (uint64_t i = 0; i < num; ++i) {
-            entries[i].clear();
+    // If there are no buckets or nothing was written since the last clear, we are done
+    if (!buckets || !dirty) return;
+
+    // Split the buckets into a chunk per thread, each thread zeroes its own chunk.
+    // On a freshly allocated table this is also the first touch of the memory,
+    // so the pages are spread over the memory nodes of the threads that use them.
+    auto work = [this](int index, int count) {
+        uint64_t chunk = num / count;
+        uint64_t start = index * chunk;
+        uint64_t end = (index == count - 1) ? num : start + chunk;
+        std::memset(static_cast<void*>(&buckets[start]), 0, (end - start) * sizeof(TTbucket));
+    };
+
+    if (runner) runner(work);
+    else work(0, 1);
+
+    dirty = false;
+}
+
+void TTtable::reallocate() {
+    if (!buckets || backing == BACKING_SHARED || backing == BACKING_FILE) return;
+    resize(size / (1024 * 1024));
+}
+
+void TTtable::dealloc() {
+    // If buckets exist then deallocate them
+    if (buckets) {
+        #if defined(__linux__)
+        if (backing == BACKING_HUGE) munmap(buckets, size);
+        else if (backing == BACKING_SHARED) detach_shared();
+        else if (backing == BACKING_FILE)
+            munmap(reinterpret_cast<char*>(buckets) - TT_FILE_HEADER_SIZE, size + TT_FILE_HEADER_SIZE);
+        else aligned_free(buckets);
+        #else
+        aligned_free(buckets);
+        #endif
+    }
+
+    // Reset the storage so it is not deallocated twice
+    buckets = nullptr;
+    backing = BACKING_NONE;
+}
+
+void TTtable::set_shared(const std::string& name) {
+    // Shared memory names must begin with a slash
+    sharedName = (name.empty() || name[0] == '/') ? name : "/" + name;
+    // Reallocate the table at the current size with the new backing
+    resize(std::max(static_cast<size_t>(1), static_cast<size_t>(size / (1024 * 1024))));
+}
+
+bool TTtable::attach_shared(size_t bytes) {
+    #if defined(__linux__)
+    // Open or create the segment, holding the serial lock while attaching so other
+    // processes cannot attach or detach at the same time. Retry if the segment was
+    // removed while waiting for the lock, the next attempt then creates a new one.
+    int fd = -1;
+    for (int attempt = 0; attempt < 8 && fd < 0; ++attempt) {
+        fd = shm_open(sharedName.c_str(), O_RDWR | O_CREAT, 0600);
+        if (fd < 0) return false;
+
+        if (!lock_shared_byte(fd, SHARED_SERIAL_BYTE, F_WRLCK, true) || !is_linked(fd, sharedName)) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    if (fd < 0) return false;
+
+    struct stat st;
+    bool created = !fstat(fd, &st) && st.st_size == 0;
+    void* mem = MAP_FAILED;
+
+    // The first process sizes the segment, which the kernel fills with zeroes
+    if (created) {
+        if (!ftruncate(fd, TT_FILE_HEADER_SIZE + bytes))
+            mem = mmap(nullptr, TT_FILE_HEADER_SIZE + bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+        if (mem != MAP_FAILED) {
+            TTsharedHeader* header = static_cast<TTsharedHeader*>(mem);
+            std::memcpy(header->magic, TT_FILE_MAGIC, sizeof(header->magic));
+            header->version = TT_FILE_VERSION;
+            header->entrySize = sizeof(TTentry);
+            header->bucketSize = TT_BUCKET_SIZE;
+            header->buckets = bytes / sizeof(TTbucket);
+        }
+    }
+    // Later processes adopt the size of the existing segment if its layout matches
+    else if (static_cast<size_t>(st.st_size) > TT_FILE_HEADER_SIZE) {
+        mem = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+        if (mem != MAP_FAILED) {
+            TTsharedHeader* header = static_cast<TTsharedHeader*>(mem);
+            if (std::memcmp(header->magic, TT_FILE_MAGIC, sizeof(header->magic))
+                || header->version != TT_FILE_VERSION
+                || header->entrySize != sizeof(TTentry)
+                || header->bucketSize != TT_BUCKET_SIZE
+                || TT_FILE_HEADER_SIZE + header->buckets * sizeof(TTbucket) != static_cast<size_t>(st.st_size)) {
+                munmap(mem, st.st_size);
+                mem = MAP_FAILED;
+            }
         }
     }
+
+    // Mark this process as attached, keeping the descriptor open to hold the lock
+    if (mem != MAP_FAILED && lock_shared_byte(fd, SHARED_ALIVE_BYTE, F_RDLCK, true)) {
+        TTsharedHeader* header = static_cast<TTsharedHeader*>(mem);
+        buckets = reinterpret_cast<TTbucket*>(static_cast<char*>(mem) + TT_FILE_HEADER_SIZE);
+        size = header->buckets * sizeof(TTbucket);
+        backing = BACKING_SHARED;
+        attachedName = sharedName;
+        sharedFd = fd;
+        lock_shared_byte(fd, SHARED_SERIAL_BYTE, F_UNLCK, false);
+        return true;
+    }
+
+    // Remove a segment we created but could not use
+    if (mem != MAP_FAILED) munmap(mem, st.st_size ? st.st_size : TT_FILE_HEADER_SIZE + bytes);
+    if (created) shm_unlink(sharedName.c_str());
+
+    close(fd);
+    return false;
+    #else
+    (void)bytes;
+    return false;
+    #endif
 }
 
-void TTtable::dealloc() {
-    // If entries exist then deallocate them
-    if (entries) aligned_free(entries);
+void TTtable::detach_shared() {
+    #if defined(__linux__)
+    TTsharedHeader* header = reinterpret_cast<TTsharedHeader*>(
+        reinterpret_cast<char*>(buckets) - TT_FILE_HEADER_SIZE);
+
+    // Hold the serial lock while detaching so no process attaches to a segment
+    // being removed. The last process attached, which is the only one able to
+    // take the alive lock exclusively, removes the segment. Closing the descriptor
+    // releases both locks, including those of a process that never gets here.
+    lock_shared_byte(sharedFd, SHARED_SERIAL_BYTE, F_WRLCK, true);
+    if (lock_shared_byte(sharedFd, SHARED_ALIVE_BYTE, F_WRLCK, false))
+        shm_unlink(attachedName.c_str());
+
+    munmap(header, size + TT_FILE_HEADER_SIZE);
+    close(sharedFd);
+
+    sharedFd = -1;
+    attachedName.clear();
+    #endif
+}
+
+bool TTtable::save_file(const std::string& path) const {
+    if (!buckets) return false;
+
+    // Open the file for writing
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    // Fill in the header, padding it out to a full page
+    char header[TT_FILE_HEADER_SIZE] = {};
+    TTfileHeader info;
+    std::memcpy(info.magic, TT_FILE_MAGIC, sizeof(info.magic));
+    info.version = TT_FILE_VERSION;
+    info.entrySize = sizeof(TTentry);
+    info.bucketSize = TT_BUCKET_SIZE;
+    info.generation = generation;
+    info.buckets = num;
+    std::memcpy(header, &info, sizeof(info));
+
+    // Write the header followed by the buckets
+    file.write(header, TT_FILE_HEADER_SIZE);
+    file.write(reinterpret_cast<const char*>(buckets), num * sizeof(TTbucket));
+
+    return static_cast<bool>(file);
+}
+
+bool TTtable::load_file(const std::string& path) {
+    // Read the header and make sure it matches the layout of this build
+    TTfileHeader info;
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+
+    uint64_t fileSize = file.tellg();
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(&info), sizeof(info));
+
+    if (!file
+        || std::memcmp(info.magic, TT_FILE_MAGIC, sizeof(info.magic))
+        || info.version != TT_FILE_VERSION
+        || info.entrySize != sizeof(TTentry)
+        || info.bucketSize != TT_BUCKET_SIZE
+        || !info.buckets
+        || fileSize != TT_FILE_HEADER_SIZE + info.buckets * sizeof(TTbucket))
+        return false;
+
+    uint64_t bytes = info.buckets * sizeof(TTbucket);
+
+    #if defined(__linux__)
+    // Map the file privately, pages are only read in once they are probed and
+    // any writes made by the search stay in memory rather than the file.
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    void* mem = mmap(nullptr, TT_FILE_HEADER_SIZE + bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) return false;
+
+    dealloc();
+    buckets = reinterpret_cast<TTbucket*>(static_cast<char*>(mem) + TT_FILE_HEADER_SIZE);
+    backing = BACKING_FILE;
+    #else
+    // Without mapping support read the buckets into a new allocation
+    dealloc();
+    buckets = static_cast<TTbucket*>(aligned_malloc(2 * 1024 * 1024, bytes));
+    backing = BACKING_NORMAL;
+
+    file.seekg(TT_FILE_HEADER_SIZE);
+    file.read(reinterpret_cast<char*>(buckets), bytes);
+    #endif
+
+    // Set internal variables to reflect the loaded table
+    size = bytes;
+    num = info.buckets;
+    generation = info.generation & 0x1F;
+    dirty = true;
+
+    return true;
 }
 
 int TTtable::hashfull() const {
     // Start with a count of zero
     int count = 0;
-    // Loop through 1000 entries as an approximate value
-    for (int idx = 0; idx < 1000; ++idx)
-        // Only count entries with a key that are at the current generation,
-        // this is done to avoid counting older entries since they can be replaced
-        count += static_cast<bool>(entries[idx].key32)
-            && static_cast<bool>(entries[idx].age8 == generation);
+    // Loop through the first 1000 entries as an approximate value
+    for (int idx = 0; idx < 1000 / TT_BUCKET_SIZE; ++idx)
+        for (const TTentry& entry : buckets[idx].entries)
+            // Only count entries with a key that are at the current generation,
+            // this is done to avoid counting older entries since they can be replaced
+            count += static_cast<bool>(entry.key())
+                && static_cast<bool>(entry.age() == generation);
     return count;
 }
 
 void TTtable::prefetch(Key key) const {
-    // Get the entry for this key
-    const TTentry* entry = &entries[(num - 1) & key];
+    // Get the bucket for this key
+    const TTbucket* bkt = bucket(key);
     // Use intrinsic prefetch depending on OS
     #if defined(_WIN32) || defined(WIN32)
-    _mm_prefetch(entry, _MM_HINT_T0);
+    _mm_prefetch(reinterpret_cast<const char*>(bkt), _MM_HINT_T0);
     #else
-    __builtin_prefetch(entry);
+    __builtin_prefetch(bkt);
     #endif
 }
 
 void TTtable::new_search() {
-    generation == 255 ? generation = 0 : generation++;
+    dirty = true;
+
+    // All processes sharing a table advance the same generation
+    if (backing == BACKING_SHARED) {
+        #if defined(__linux__)
+        TTsharedHeader* header = reinterpret_cast<TTsharedHeader*>(
+            reinterpret_cast<char*>(buckets) - TT_FILE_HEADER_SIZE);
+        generation = __atomic_add_fetch(&header->generation, 1, __ATOMIC_RELAXED) & 0x1F;
+        return;
+        #endif
+    }
+
+    generation = (generation + 1) & 0x1F;
 }
 
 size_t TTtable::num_entries() const {
-    return num;
+    return num * TT_BUCKET_SIZE;
 }
 
 size_t TTtable::size_entries() const {
@@ -141,4 +600,15 @@ size_t TTtable::max_size() const {
     return maxSize;
 }
 
+const char* TTtable::backing_name() const {
+    switch (backing) {
+        case BACKING_HUGE:        return "explicit huge pages";
+        case BACKING_TRANSPARENT: return "transparent huge pages";
+        case BACKING_NORMAL:      return "normal pages";
+        case BACKING_FILE:        return "a mapped hash file";
+        case BACKING_SHARED:      return "shared memory";
+        default:                  return "no memory";
+    }
+}
+
 }
@@ -1,7 +1,9 @@
 #ifndef INCLUDE_TT_HPP
 #define INCLUDE_TT_HPP
 
+#include <functional>
 #include <memory>
+#include <string>
 
 #include "types.hpp"
 
@@ -13,26 +15,31 @@ extern TTtable table;
 
 // Structure for holding an entry in the hash table
 //
-// 32 bits -> key
+// The entry is stored as two 64 bit words so it can be shared between
+// search threads without any locking. The data word is packed as:
+//
 // 16 bits -> score
 // 16 bits -> eval
 // 16 bits -> move
 // 8 bits -> depth
-// 8 bits -> node
-// 8 bits -> age
+// 8 bits -> age (5 bits), pv (1 bit) and bound (2 bits)
+//
+// The key word holds the full hash key xor'd with the data word. A thread
+// reading both words written by two different stores will then recover
+// a key that does not match its own, so a torn entry is treated as a miss.
 //
-// Totals to 13 bytes, aligned to 16 bytes for faster accessing
+// Totals to 16 bytes, aligned to 16 bytes so four entries fill a bucket
 struct alignas(16) TTentry {
 public:
     // Return members of the entry
-    uint32_t key() const { return key32; }
-    int16_t score() const { return score16; }
-    int16_t eval() const { return eval16; }
-    Move move() const { return move16; }
-    uint8_t depth() const { return depth8; }
-    uint8_t node() const { return node8 & 0x3; }
-    uint8_t age() const { return age8; }
-    bool is_pv() const { return node8 & 0x4; }
+    Key key() const { return key64 ^ data64; }
+    int16_t score() const { return static_cast<int16_t>(data64); }
+    int16_t eval() const { return static_cast<int16_t>(data64 >> 16); }
+    Move move() const { return Move(static_cast<int16_t>(data64 >> 32)); }
+    uint8_t depth() const { return static_cast<uint8_t>(data64 >> 48); }
+    uint8_t node() const { return static_cast<uint8_t>(data64 >> 56) & 0x3; }
+    uint8_t age() const { return static_cast<uint8_t>(data64 >> 56) >> 3; }
+    bool is_pv() const { return (data64 >> 56) & 0x4; }
 
     // Overload operators to allocate memory for an entry
     static void* operator new (size_t alignment, size_t size) {
@@ -47,13 +54,31 @@ public:
 
 private:
     friend class TTtable;
-    uint32_t key32;
-    int16_t score16;
-    int16_t eval16;
-    Move move16;
-    uint8_t depth8;
-    uint8_t node8;
-    uint8_t age8;
+    uint64_t key64;
+    uint64_t data64;
+};
+
+// Number of entries stored in a single bucket
+constexpr int TT_BUCKET_SIZE = 4;
+
+// Structure for a bucket of entries in the hash table. Every key maps to
+// one bucket, which is sized and aligned to a cache line so that a probe
+// only ever touches a single line of memory while still holding several
+// positions that would otherwise evict one another.
+struct alignas(64) TTbucket {
+    TTentry entries[TT_BUCKET_SIZE];
+};
+
+static_assert(sizeof(TTbucket) == 64, "TTbucket must fill exactly one cache line");
+
+// Type of memory backing the transposition table
+enum TTbacking {
+    BACKING_NONE,
+    BACKING_NORMAL,
+    BACKING_TRANSPARENT,
+    BACKING_HUGE,
+    BACKING_FILE,
+    BACKING_SHARED
 };
 
 // Class for a transposition table, allocates a given amount of memory
@@ -66,8 +91,29 @@ private:
     uint64_t num;
     uint64_t size;
     uint64_t maxSize = (1 << 12) * sizeof(TTentry);
-    // Storage for the entries
-    TTentry* entries;
+    // Storage for the buckets
+    TTbucket* buckets;
+    // Memory backing of the buckets
+    TTbacking backing = BACKING_NONE;
+    // Runs a task on a set of threads at once, passing each its index and the
+    // number of threads. Empty until set, when the calling thread does the work.
+    std::function<void(const std::function<void(int, int)>&)> runner;
+    // Whether the table may hold entries since it was last cleared
+    bool dirty = true;
+    // Name of the shared memory segment to back the table with, empty if private
+    std::string sharedName;
+    // Name of the shared memory segment currently attached to
+    std::string attachedName;
+    // Descriptor of the attached segment, holding the locks that mark this process as attached
+    int sharedFd = -1;
+
+    // Get the bucket for a given hash key
+    TTbucket* bucket(Key key) const;
+    // Read an entry from the table into a local copy
+    static TTentry load(const TTentry* entry);
+    // Attach to or detach from the named shared memory segment
+    bool attach_shared(size_t bytes);
+    void detach_shared();
 
 public:
     // Destructor for the table so it cleans itself up
@@ -75,30 +121,54 @@ public:
     // Functions to access the transposition table
 
     // Used to save an entry to the transposition table, takes into account
-    // the ages of stored entries aswell as the arguments given to determine
-    // if an overwrite will occur.
+    // the ages and depths of entries in the bucket aswell as the arguments given
+    // to determine which entry, if any, will be overwritten.
     template<NodeType T>
     void save(Key key, Depth depth, Value score, Value eval, Move m, Bound b);
 
-    // Function for retrieving an entry from the table, sets a given boolean to true if found
-    TTentry* probe(Key key, bool& found) const;
+    // Function for retrieving an entry from the table, sets a given boolean to true if found.
+    // Returns a copy of the entry read at once, so it cannot change while in use.
+    TTentry probe(Key key, bool& found) const;
 
-    // Clear the table
+    // Clear the table, splitting the work across the configured threads. A table
+    // which has not been searched with since the last clear only resets its generation.
     void clear();
+    // Set the threads used to clear the table. Clearing on the pinned search threads
+    // first touches the pages of a new table on the memory nodes that use them.
+    void set_runner(std::function<void(const std::function<void(int, int)>&)> run) { runner = std::move(run); }
     // Get the number of entries/size of the table
     size_t num_entries() const;
     size_t size_entries() const;
     size_t max_size() const;
-    // Increment age when starting a new search, loop over if max is reached
+    // Get a description of the memory backing the table
+    const char* backing_name() const;
+    // Increment age when starting a new search, loop over if max is reached.
+    // Only 5 bits are stored per entry so the age repeats every 32 searches.
     void new_search();
-    // Resize/initialize the table to a given number of megabytes
+    // Resize/initialize the table to a given number of megabytes. Explicit huge pages
+    // are tried first, then transparent huge pages and finally normal pages.
     void resize(size_t mb);
     // Deallocate the memory from the table
     void dealloc();
+    // Allocate a private table again at the same size, so its pages are first touched
+    // by the clearing threads after they moved. Shared and loaded tables are kept.
+    void reallocate();
+    // Back the table with a named shared memory segment so cooperating processes
+    // share their entries, an empty name returns to a private table.
+    void set_shared(const std::string& name);
+    // Write the table to a file as a versioned header followed by the raw buckets
+    bool save_file(const std::string& path) const;
+    // Load a table previously written with save_file, replacing the current one.
+    // Where possible the file is mapped into memory rather than read in.
+    bool load_file(const std::string& path);
     // Returns an approximation in the range [0, 1000] of how full the table is
     int hashfull() const;
     // Prefetch the entry for a given hash key
     void prefetch(Key key) const;
+    // Debug check for torn reads. Several threads save and probe keys which all map
+    // to the first bucket, counting every probe that accepts an entry whose data
+    // does not belong to its key. The contents of the table are lost.
+    void stress_test(int threads, uint64_t iterations, uint64_t& hits, uint64_t& mismatches);
 };
 
 }
@@ -21,6 +21,16 @@
 constexpr bool hasPext = true;
 #include <immintrin.h>
 #define pext(b, m) _pext_u64(b, m)
+#elif defined(USE_DISPATCH)
+// When choosing code paths at runtime, pext is set by Cpu::init. The
+// instruction is written as inline assembly, which unlike an intrinsic needs
+// no bmi2 target and so inlines into the lookups, it only runs once found.
+extern bool hasPext;
+inline uint64_t pext(uint64_t b, uint64_t m) {
+    uint64_t result;
+    asm("pextq %2, %1, %0" : "=r"(result) : "r"(b), "rm"(m));
+    return result;
+}
 #else
 constexpr bool hasPext = false;
 #define pext(b, m) 0
@@ -1,4 +1,5 @@
 #include "uci.hpp"
+#include "cpu.hpp"
 #include "perft.hpp"
 #include "types.hpp"
 #include "movegen.hpp"
@@ -9,6 +10,7 @@
 #include "timing.hpp"
 #include "nn/evaluate.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <vector>
@@ -70,6 +72,8 @@ inline uint64_t get_val_from_key(std::string str, std::string key) {
 Uci::Uci() {
     // Set default threads
     s.set_threads(1);
+    // Clear the transposition table on the search threads
+    table.set_runner([this](const std::function<void(int, int)>& task) { s.run_on_threads(task); });
     // Init the lmr array
     s.init_lmr();
     // Set default transposition table size
@@ -78,6 +82,7 @@ Uci::Uci() {
 
 Uci::~Uci() {
     quit();
+    table.set_runner(nullptr);
 }
 
 const Move Uci::to_move(std::string move) {
@@ -115,6 +120,26 @@ void Uci::uci() {
               << std::endl
               << "option name MoveOverhead type spin default 0 min 0 max 1000"
               << std::endl
+              << "option name Ponder type check default false"
+              << std::endl
+              << "option name SMPMode type combo default LazySMP var LazySMP var ABDADA"
+              << std::endl
+              << "option name HelperSkipDepths type check default true"
+              << std::endl
+              << "option name HelperDepthOffset type spin default 0 min 0 max 1"
+              << std::endl
+              << "option name MultiPV type spin default 1 min 1 max "
+              << MAX_MOVES
+              << std::endl
+              << "option name SharedHash type string default <empty>"
+              << std::endl
+              << "option name Affinity type string default none"
+              << std::endl
+              << "option name NUMA type check default false"
+              << std::endl
+              << "info string Using "
+              << Cpu::description()
+              << std::endl
               << "uciok"
               << std::endl;
 }
@@ -178,15 +203,33 @@ void Uci::parse(std::string command) {
     else if (token == "stop") {
         stop();
     }
+    else if (token == "ponderhit") {
+        tm.ponderhit();
+    }
     else if (token == "eval") {
         std::cout << network.predict(&pos) << std::endl;
     }
     else if (token == "bench") {
-        bench();
+        // "bench threads N" repeats the bench for 1, 2, 4 ... N threads
+        if (args.size() > 2 && args[1] == "threads" && is_number(args[2]))
+            bench_threads(std::stoi(args[2]));
+        else
+            bench();
     }
     else if (token == "d") {
         std::cout << pos << std::endl;
     }
+    else if (token == "savehash" || token == "loadhash") {
+        // The path is the remainder of the command
+        std::string path = command.size() > token.size() ? command.substr(token.size() + 1) : "";
+        hashfile(token == "loadhash", path);
+    }
+    else if (token == "hashtest") {
+        // Optional thread count and number of operations per thread
+        int threads = args.size() > 1 && is_number(args[1]) ? std::stoi(args[1]) : 4;
+        uint64_t iterations = args.size() > 2 && is_number(args[2]) ? std::stoull(args[2]) : 1000000;
+        hashtest(std::max(threads, 1), iterations);
+    }
     else if (token == "exit" || token == "quit") {
         stop();
         exit(0);
@@ -256,9 +299,22 @@ void Uci::parse_go(std::string command) {
     if (movetime) {
         tm.set_move_time_limit(movetime);
     }
+    // Ponder on the expected reply, limits only apply after a ponderhit
+    std::vector<std::string> args = split(command, ' ');
+    if (std::find(args.begin(), args.end(), "ponder") != args.end()) {
+        tm.ponder.store(true, std::memory_order_relaxed);
+    }
+    // Root moves to search, every move after the keyword is read until
+    // a word that is not a legal move in this position
+    auto searchmoves = std::find(args.begin(), args.end(), "searchmoves");
+    if (searchmoves != args.end()) {
+        Move m;
+        for (auto it = searchmoves + 1; it != args.end() && (m = to_move(*it)) != Move::none(); ++it)
+            tm.searchMoves.push_back(m);
+    }
 
     // Start the search
-    mainThread = std::thread(&Uci::search, this);
+    s.start(&pos, &tm);
 }
 
 void Uci::parse_position(std::string command) {
@@ -314,21 +370,125 @@ void Uci::parse_option(std::string opt, std::string val) {
     if (opt == "Threads") {
         numThreads = is_number(val) ? std::stoi(val) : 1;
         s.set_threads(numThreads);
+        // Place the table on the memory of the new threads
+        table.reallocate();
     }
     else if (opt == "Hash") {
         size_t mb = is_number(val) ? std::stoi(val) : 16;
         table.resize(mb);
+        // Report which type of memory was obtained for the table
+        std::cout << "info string Hash set to "
+                  << table.size_entries() / (1024 * 1024)
+                  << " MB using "
+                  << table.backing_name()
+                  << std::endl;
+    }
+    else if (opt == "SMPMode") {
+        s.set_smp_mode(val == "ABDADA" ? SMP_ABDADA : SMP_LAZY);
+    }
+    else if (opt == "HelperSkipDepths") {
+        s.set_skip_depths(val == "true");
+    }
+    else if (opt == "HelperDepthOffset") {
+        s.set_helper_depth_offset(is_number(val) ? std::stoi(val) : 0);
+    }
+    else if (opt == "MultiPV") {
+        s.set_multipv(is_number(val) ? std::stoi(val) : 1);
+    }
+    else if (opt == "Affinity") {
+        // Accepts none, compact, scatter or a cpu list such as 0-7,16-23
+        if (!s.set_affinity(val)) {
+            std::cout << "info string Affinity " << val << " gives no usable cpus" << std::endl;
+            return;
+        }
+
+        table.reallocate();
+
+        std::cout << "info string Affinity set to " << val;
+        if (!s.affinity_cpus().empty()) {
+            std::cout << " using cpus";
+            for (int cpu : s.affinity_cpus()) std::cout << " " << cpu;
+        }
+        std::cout << std::endl;
+    }
+    else if (opt == "NUMA") {
+        int nodes = s.set_numa(val == "true");
+        table.reallocate();
+        // Replication only takes place with more than one node
+        if (val == "true")
+            std::cout << "info string NUMA "
+                      << (nodes > 1 ? "replicating network weights on " : "found only ")
+                      << nodes << " nodes" << std::endl;
+    }
+    else if (opt == "SharedHash") {
+        // An empty value returns to a private table
+        table.set_shared(val == "<empty>" ? "" : val);
+        // Report which type of memory was obtained for the table
+        std::cout << "info string Hash set to "
+                  << table.size_entries() / (1024 * 1024)
+                  << " MB using "
+                  << table.backing_name()
+                  << std::endl;
     }
 }
 
+void Uci::hashfile(bool load, std::string path) {
+    // Make sure a search is not using the table
+    stop();
+
+    if (path.empty()) {
+        std::cout << "info string No hash file given" << std::endl;
+        return;
+    }
+
+    // Save or load the table, reporting the result
+    if (!load) {
+        std::cout << "info string "
+                  << (table.save_file(path) ? "Hash saved to " : "Failed to save hash to ")
+                  << path
+                  << std::endl;
+    }
+    else if (table.load_file(path)) {
+        std::cout << "info string Hash loaded from "
+                  << path
+                  << ", "
+                  << table.size_entries() / (1024 * 1024)
+                  << " MB using "
+                  << table.backing_name()
+                  << std::endl;
+    }
+    else {
+        std::cout << "info string Failed to load hash from " << path << std::endl;
+    }
+}
+
+void Uci::hashtest(int threads, uint64_t iterations) {
+    // Make sure a search is not using the table
+    stop();
+
+    uint64_t hits, mismatches;
+    table.stress_test(threads, iterations, hits, mismatches);
+
+    std::cout << "info string Hash test "
+              << threads
+              << " threads, "
+              << hits
+              << " hits, "
+              << mismatches
+              << " mismatches"
+              << std::endl;
+}
+
 void Uci::newgame() {
+    // Make sure a search is not using the table or thread data
+    stop();
     s.clear_thread_data();
     table.clear();
 }
 
 void Uci::stop() {
     tm.stop();
-    if (mainThread.joinable()) mainThread.join();
+    s.wait_for_search();
 }
 
 static const std::string benchPositions[50] = {
@@ -384,9 +544,8 @@ static const std::string benchPositions[50] = {
     "2r2b2/5p2/5k2/p1r1pP2/P2pB3/1P3P2/K1P3R1/7R w - - 23 93"
 };
 
-void Uci::bench() {
-    uint64_t nodes = 0;
-    uint64_t time = 0;
+void Uci::run_bench(uint64_t& nodes, uint64_t& time) {
+    nodes = time = 0;
 
     for (int i = 0; i < 50; ++i) {
         // Initialize a position with the given bench position
@@ -405,6 +564,11 @@ void Uci::bench() {
         s.clear_thread_data();
         table.clear();
     }
+}
+
+void Uci::bench() {
+    uint64_t nodes, time;
+    run_bench(nodes, time);
 
     // Print overall stats
     std::cout << std::endl;
@@ -413,6 +577,39 @@ void Uci::bench() {
     std::cout << 1000 * nodes / (time + 1) << " nps" << std::endl;
 }
 
+void Uci::bench_threads(int maxThreads) {
+    // Each position is searched to a fixed depth, so the time of a run is the
+    // time to depth and the nodes show how much work the threads duplicate
+    struct Result { int threads; uint64_t nodes; uint64_t time; };
+    std::vector<Result> results;
+
+    for (int threads = 1; ; threads = std::min(2 * threads, maxThreads)) {
+        s.set_threads(threads);
+        // Stop once the cpus available are used up
+        if (s.thread_count() != threads) break;
+
+        uint64_t nodes, time;
+        run_bench(nodes, time);
+        results.push_back({ threads, nodes, time });
+
+        if (threads >= maxThreads) break;
+    }
+
+    // Restore the configured threads
+    s.set_threads(numThreads);
+
+    std::cout << std::endl;
+    std::cout << "-- Bench Scaling --" << std::endl;
+    for (const Result& r : results) {
+        std::cout << r.threads << " threads "
+                  << r.nodes << " nodes "
+                  << r.time << " ms "
+                  << 1000 * r.nodes / (r.time + 1) << " nps "
+                  << "speedup " << double(results[0].time + 1) / (r.time + 1)
+                  << std::endl;
+    }
+}
+
 void Uci::quit() {
     // Stop the search
     stop();
@@ -420,9 +617,4 @@ void Uci::quit() {
     table.dealloc();
 }
 
-void Uci::search() {
-    Move m = s.search(&pos, &tm);
-    std::cout << "bestmove " << from_move(m, pos.is_chess960()) << std::endl;
-}
-
 }
@@ -13,13 +13,15 @@ namespace Stella {
 class Uci {
 
 private:
-    std::thread mainThread;
     Search s;
     TimeManager tm;
     Position pos = Position("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", false);
     Network::Evaluator network;
     int numThreads = 1;
 
+    // Search every bench position to a fixed depth, totalling the nodes and time taken
+    void run_bench(uint64_t& nodes, uint64_t& time);
+
 public:
     Uci();
     ~Uci();
@@ -42,6 +44,12 @@ public:
     // Function to parse a command beginning in "setoption", for example "setoption name Hash value 16".
     void parse_option(std::string opt, std::string val);
 
+    // Save or load the transposition table to a file, for example "savehash analysis.hash".
+    void hashfile(bool load, std::string path);
+
+    // Check that no torn entries are read from the table, for example "hashtest 8 1000000".
+    void hashtest(int threads, uint64_t iterations);
+
     // Start a new game
     void newgame();
 
@@ -54,11 +62,11 @@ public:
     // Bench function to run a benchmark, used for profile guided optimization and performace testing.
     void bench();
 
+    // Repeat the bench for 1, 2, 4 ... N threads, reporting nodes, time to depth and nps for each.
+    void bench_threads(int maxThreads);
+
     // Quit the program.
     void quit();
-
-    // Initiate a search.
-    void search();
 };
 
 }